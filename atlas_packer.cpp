@@ -0,0 +1,234 @@
+#include "atlas_packer.hpp"
+#include <algorithm>
+#include <climits>
+
+namespace
+{
+    bool contains(const atlas_rect& outer, const atlas_rect& inner)
+    {
+        return inner.pos.x() >= outer.pos.x() && inner.pos.y() >= outer.pos.y() &&
+               inner.pos.x() + inner.dim.x() <= outer.pos.x() + outer.dim.x() &&
+               inner.pos.y() + inner.dim.y() <= outer.pos.y() + outer.dim.y();
+    }
+
+    bool intersects(const atlas_rect& r1, const atlas_rect& r2)
+    {
+        return r1.pos.x() < r2.pos.x() + r2.dim.x() && r2.pos.x() < r1.pos.x() + r1.dim.x() &&
+               r1.pos.y() < r2.pos.y() + r2.dim.y() && r2.pos.y() < r1.pos.y() + r1.dim.y();
+    }
+
+    ///best short side fit
+    std::optional<vec2i> find_position(const std::vector<atlas_rect>& free_rects, vec2i dim)
+    {
+        std::optional<vec2i> best;
+        int best_short = INT_MAX;
+        int best_long = INT_MAX;
+
+        for(const atlas_rect& r : free_rects)
+        {
+            if(r.dim.x() < dim.x() || r.dim.y() < dim.y())
+                continue;
+
+            int leftover_x = r.dim.x() - dim.x();
+            int leftover_y = r.dim.y() - dim.y();
+
+            int short_side = std::min(leftover_x, leftover_y);
+            int long_side = std::max(leftover_x, leftover_y);
+
+            if(short_side < best_short || (short_side == best_short && long_side < best_long))
+            {
+                best = r.pos;
+                best_short = short_side;
+                best_long = long_side;
+            }
+        }
+
+        return best;
+    }
+
+    void prune(std::vector<atlas_rect>& free_rects)
+    {
+        for(int i=0; i < (int)free_rects.size(); i++)
+        {
+            for(int j=i+1; j < (int)free_rects.size(); j++)
+            {
+                if(contains(free_rects[j], free_rects[i]))
+                {
+                    free_rects.erase(free_rects.begin() + i);
+                    i--;
+                    break;
+                }
+
+                if(contains(free_rects[i], free_rects[j]))
+                {
+                    free_rects.erase(free_rects.begin() + j);
+                    j--;
+                }
+            }
+        }
+    }
+
+    ///carves used out of every free rect it overlaps, leaving the maximal rectangles around it
+    void split(std::vector<atlas_rect>& free_rects, const atlas_rect& used)
+    {
+        std::vector<atlas_rect> produced;
+        std::vector<atlas_rect> kept;
+
+        for(int i=0; i < (int)free_rects.size(); i++)
+        {
+            atlas_rect r = free_rects[i];
+
+            if(!intersects(r, used))
+                continue;
+
+            int r_x1 = r.pos.x() + r.dim.x();
+            int r_y1 = r.pos.y() + r.dim.y();
+            int u_x1 = used.pos.x() + used.dim.x();
+            int u_y1 = used.pos.y() + used.dim.y();
+
+            if(used.pos.x() > r.pos.x())
+                produced.push_back({r.pos, {used.pos.x() - r.pos.x(), r.dim.y()}});
+
+            if(u_x1 < r_x1)
+                produced.push_back({{u_x1, r.pos.y()}, {r_x1 - u_x1, r.dim.y()}});
+
+            if(used.pos.y() > r.pos.y())
+                produced.push_back({r.pos, {r.dim.x(), used.pos.y() - r.pos.y()}});
+
+            if(u_y1 < r_y1)
+                produced.push_back({{r.pos.x(), u_y1}, {r.dim.x(), r_y1 - u_y1}});
+
+            free_rects.erase(free_rects.begin() + i);
+            i--;
+        }
+
+        ///the rects that weren't split were already maximal, and can't be inside any of the new ones, so only the new ones need checking
+        for(int k=0; k < (int)produced.size(); k++)
+        {
+            const atlas_rect& piece = produced[k];
+
+            bool redundant = false;
+
+            for(const atlas_rect& r : free_rects)
+            {
+                if(contains(r, piece))
+                {
+                    redundant = true;
+                    break;
+                }
+            }
+
+            for(int m=0; m < (int)produced.size() && !redundant; m++)
+            {
+                ///of two identical pieces, only the first is kept
+                if(m != k && contains(produced[m], piece) && (m < k || !contains(piece, produced[m])))
+                    redundant = true;
+            }
+
+            if(!redundant)
+                kept.push_back(piece);
+        }
+
+        free_rects.insert(free_rects.end(), kept.begin(), kept.end());
+    }
+
+
+    ///joins free rects that share a whole edge, so that evicted space can be reused for bigger entries
+    void merge(std::vector<atlas_rect>& free_rects)
+    {
+        bool any = true;
+
+        while(any)
+        {
+            any = false;
+
+            for(int i=0; i < (int)free_rects.size() && !any; i++)
+            {
+                for(int j=0; j < (int)free_rects.size() && !any; j++)
+                {
+                    if(i == j)
+                        continue;
+
+                    atlas_rect& r1 = free_rects[i];
+                    atlas_rect& r2 = free_rects[j];
+
+                    bool horizontal = r1.pos.y() == r2.pos.y() && r1.dim.y() == r2.dim.y() && r1.pos.x() + r1.dim.x() == r2.pos.x();
+                    bool vertical = r1.pos.x() == r2.pos.x() && r1.dim.x() == r2.dim.x() && r1.pos.y() + r1.dim.y() == r2.pos.y();
+
+                    if(!horizontal && !vertical)
+                        continue;
+
+                    if(horizontal)
+                        r1.dim.x() += r2.dim.x();
+                    else
+                        r1.dim.y() += r2.dim.y();
+
+                    free_rects.erase(free_rects.begin() + j);
+                    any = true;
+                }
+            }
+        }
+
+        prune(free_rects);
+    }
+}
+
+void atlas_packer::reset(vec2i _dim)
+{
+    dim = _dim;
+    used.clear();
+    fragmented = false;
+
+    free_rects.clear();
+    free_rects.push_back({{0,0}, dim});
+}
+
+std::optional<vec2i> atlas_packer::find(vec2i size)
+{
+    std::optional<vec2i> ret = find_position(free_rects, size);
+
+    if(ret.has_value() || !fragmented)
+        return ret;
+
+    rebuild();
+
+    return find_position(free_rects, size);
+}
+
+void atlas_packer::place(const atlas_rect& r)
+{
+    split(free_rects, r);
+
+    used.push_back(r);
+}
+
+void atlas_packer::release(const atlas_rect& r)
+{
+    for(int i=0; i < (int)used.size(); i++)
+    {
+        if(used[i].pos == r.pos && used[i].dim == r.dim)
+        {
+            used.erase(used.begin() + i);
+            break;
+        }
+    }
+
+    free_rects.push_back(r);
+
+    merge(free_rects);
+
+    fragmented = true;
+}
+
+void atlas_packer::rebuild()
+{
+    free_rects.clear();
+    free_rects.push_back({{0,0}, dim});
+
+    for(const atlas_rect& u : used)
+    {
+        split(free_rects, u);
+    }
+
+    fragmented = false;
+}
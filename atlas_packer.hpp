@@ -0,0 +1,40 @@
+#ifndef ATLAS_PACKER_HPP_INCLUDED
+#define ATLAS_PACKER_HPP_INCLUDED
+
+#include <vec/vec.hpp>
+#include <vector>
+#include <optional>
+
+struct atlas_rect
+{
+    vec2i pos;
+    vec2i dim;
+};
+
+///the cpu side of texture_atlas. Maxrects with best short side fit, over one page
+struct atlas_packer
+{
+    vec2i dim;
+    ///rects given to place, and not yet released
+    std::vector<atlas_rect> used;
+    ///maximal free rectangles, which may overlap
+    std::vector<atlas_rect> free_rects;
+
+    ///empties the page
+    void reset(vec2i dim);
+
+    ///where something of this size would go, without taking it
+    ///if nothing fits after evictions, the free space is rebuilt from everything still placed and searched again
+    std::optional<vec2i> find(vec2i size);
+    ///r must be inside free space
+    void place(const atlas_rect& r);
+    ///gives a placed rect back. Cheap, but only joins it with free space that shares a whole edge
+    void release(const atlas_rect& r);
+
+private:
+    bool fragmented = false;
+
+    void rebuild();
+};
+
+#endif // ATLAS_PACKER_HPP_INCLUDED
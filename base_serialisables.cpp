@@ -14,4 +14,8 @@ DEFINE_SERIALISE_FUNCTION(render_settings)
     DO_FSERIALISE(viewports);
     DO_FSERIALISE(opencl);
     DO_FSERIALISE(vsync);
+    DO_FSERIALISE(damage_tracking);
+    DO_FSERIALISE(frames_in_flight);
+    DO_FSERIALISE(render_thread);
+    DO_FSERIALISE(max_dropped_file_size);
 }
@@ -0,0 +1,784 @@
+#include "frost.hpp"
+#include "gl_shader.hpp"
+#include <GL/glew.h>
+#include <GL/gl.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <stdint.h>
+
+namespace
+{
+    ///bottom left origin, clamped to the screen
+    struct frost_rect
+    {
+        vec2i pos;
+        vec2i dim;
+    };
+
+    std::vector<frost_rect> to_gl_rects(const std::vector<frostable>& frosty, vec2i screen_dim)
+    {
+        std::vector<frost_rect> ret;
+
+        for(const frostable& f : frosty)
+        {
+            vec2i pos = {(int)f.pos.x(), screen_dim.y() - (int)f.pos.y() - f.dim.y()};
+
+            vec2i lo = {std::clamp(pos.x(), 0, screen_dim.x()), std::clamp(pos.y(), 0, screen_dim.y())};
+            vec2i hi = {std::clamp(pos.x() + f.dim.x(), 0, screen_dim.x()), std::clamp(pos.y() + f.dim.y(), 0, screen_dim.y())};
+
+            if(hi.x() <= lo.x() || hi.y() <= lo.y())
+                continue;
+
+            ret.push_back({lo, hi - lo});
+        }
+
+        return ret;
+    }
+
+    ///frost runs in the middle of imgui's draw, so everything it touches is put back the way it was found
+    struct gl_state_saver
+    {
+        GLint draw_fbo = 0;
+        GLint read_fbo = 0;
+        GLint program = 0;
+        GLint active_texture = 0;
+        GLint texture = 0;
+        GLint array_buffer = 0;
+        GLint pack_buffer = 0;
+        GLint unpack_buffer = 0;
+        GLint pack_alignment = 4;
+        GLint unpack_alignment = 4;
+        GLint viewport[4] = {};
+        GLint scissor[4] = {};
+        GLboolean scissor_test = false;
+        GLboolean blend = false;
+
+        #ifndef __EMSCRIPTEN__
+        GLint vao = 0;
+        #endif
+
+        gl_state_saver()
+        {
+            glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &draw_fbo);
+            glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_fbo);
+            glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+            glGetIntegerv(GL_ACTIVE_TEXTURE, &active_texture);
+
+            glActiveTexture(GL_TEXTURE0);
+            glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+
+            glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &array_buffer);
+            glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &pack_buffer);
+            glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &unpack_buffer);
+            glGetIntegerv(GL_PACK_ALIGNMENT, &pack_alignment);
+            glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+            glGetIntegerv(GL_VIEWPORT, viewport);
+            glGetIntegerv(GL_SCISSOR_BOX, scissor);
+
+            scissor_test = glIsEnabled(GL_SCISSOR_TEST);
+            blend = glIsEnabled(GL_BLEND);
+
+            #ifndef __EMSCRIPTEN__
+            glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vao);
+            glBindVertexArray(0);
+            #endif
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            glDisable(GL_SCISSOR_TEST);
+            glDisable(GL_BLEND);
+        }
+
+        ~gl_state_saver()
+        {
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw_fbo);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, read_fbo);
+            glUseProgram(program);
+
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glActiveTexture(active_texture);
+
+            glBindBuffer(GL_ARRAY_BUFFER, array_buffer);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pack_buffer);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpack_buffer);
+            glPixelStorei(GL_PACK_ALIGNMENT, pack_alignment);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+            glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+            glScissor(scissor[0], scissor[1], scissor[2], scissor[3]);
+
+            if(scissor_test)
+                glEnable(GL_SCISSOR_TEST);
+            else
+                glDisable(GL_SCISSOR_TEST);
+
+            if(blend)
+                glEnable(GL_BLEND);
+            else
+                glDisable(GL_BLEND);
+
+            #ifndef __EMSCRIPTEN__
+            glBindVertexArray(vao);
+            #endif
+        }
+    };
+
+    struct render_target
+    {
+        unsigned int fbo = 0;
+        unsigned int tex = 0;
+        vec2i dim;
+
+        void create(vec2i _dim)
+        {
+            destroy();
+
+            dim = _dim;
+
+            glGenTextures(1, &tex);
+            glBindTexture(GL_TEXTURE_2D, tex);
+
+            #ifndef __EMSCRIPTEN__
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, dim.x(), dim.y(), 0, GL_RGBA, GL_FLOAT, nullptr);
+            #else
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, dim.x(), dim.y(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            #endif
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            glGenFramebuffers(1, &fbo);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+        }
+
+        void destroy()
+        {
+            if(fbo != 0)
+                glDeleteFramebuffers(1, &fbo);
+
+            if(tex != 0)
+                glDeleteTextures(1, &tex);
+
+            fbo = 0;
+            tex = 0;
+        }
+    };
+
+    void blit(unsigned int src_fbo, vec2i src_dim, unsigned int dst_fbo, vec2i dst_dim)
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, src_fbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst_fbo);
+
+        glBlitFramebuffer(0, 0, src_dim.x(), src_dim.y(), 0, 0, dst_dim.x(), dst_dim.y(), GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    }
+
+    ///scaling the blurred image back up with a linear blit, scissored to each rect
+    void composite(unsigned int src_fbo, vec2i src_dim, unsigned int screen_fbo, vec2i screen_dim, const std::vector<frost_rect>& rects)
+    {
+        glEnable(GL_SCISSOR_TEST);
+
+        for(const frost_rect& r : rects)
+        {
+            glScissor(r.pos.x(), r.pos.y(), r.dim.x(), r.dim.y());
+
+            blit(src_fbo, src_dim, screen_fbo, screen_dim);
+        }
+
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    ///the same dual kawase passes as the opencl kernels. texel is the size of one source texel
+    const char* downsample_source = R"(
+uniform sampler2D tex;
+uniform vec2 texel;
+uniform float offset;
+varying vec2 uv;
+
+void main()
+{
+    vec2 o = texel * offset;
+
+    vec4 sum = texture2D(tex, uv) * 4.0;
+
+    sum += texture2D(tex, uv + vec2(-o.x, -o.y));
+    sum += texture2D(tex, uv + vec2(o.x, -o.y));
+    sum += texture2D(tex, uv + vec2(-o.x, o.y));
+    sum += texture2D(tex, uv + vec2(o.x, o.y));
+
+    gl_FragColor = sum / 8.0;
+}
+)";
+
+    const char* upsample_source = R"(
+uniform sampler2D tex;
+uniform vec2 texel;
+uniform float offset;
+varying vec2 uv;
+
+void main()
+{
+    vec2 o = texel * offset;
+    vec2 h = o * 0.5;
+
+    vec4 sum = vec4(0.0);
+
+    sum += texture2D(tex, uv + vec2(-o.x, 0.0));
+    sum += texture2D(tex, uv + vec2(o.x, 0.0));
+    sum += texture2D(tex, uv + vec2(0.0, -o.y));
+    sum += texture2D(tex, uv + vec2(0.0, o.y));
+
+    sum += texture2D(tex, uv + vec2(-h.x, -h.y)) * 2.0;
+    sum += texture2D(tex, uv + vec2(h.x, -h.y)) * 2.0;
+    sum += texture2D(tex, uv + vec2(-h.x, h.y)) * 2.0;
+    sum += texture2D(tex, uv + vec2(h.x, h.y)) * 2.0;
+
+    gl_FragColor = sum / 12.0;
+}
+)";
+
+    constexpr int gl_frost_levels = 4;
+
+    ///the cpu blur runs several passes a frame, so its workers stay alive between them rather than being started for each one
+    struct blur_pool
+    {
+        std::mutex call_lock;
+
+        std::mutex lock;
+        std::condition_variable work_cv;
+        std::condition_variable done_cv;
+        std::vector<std::thread> threads;
+        bool quit = false;
+
+        const std::function<void(int, int)>* func = nullptr;
+        int count = 0;
+        int per_chunk = 0;
+        int chunks = 0;
+        int next_chunk = 0;
+        int remaining = 0;
+
+        blur_pool()
+        {
+            int thread_count = std::clamp((int)std::thread::hardware_concurrency(), 1, 8);
+
+            ///the calling thread does a share of the work too
+            for(int i=1; i < thread_count; i++)
+            {
+                threads.emplace_back([this](){run();});
+            }
+        }
+
+        ~blur_pool()
+        {
+            {
+                std::lock_guard guard(lock);
+                quit = true;
+            }
+
+            work_cv.notify_all();
+
+            for(std::thread& t : threads)
+            {
+                t.join();
+            }
+        }
+
+        ///call with the lock held, returns false once every chunk has been handed out
+        bool run_one(std::unique_lock<std::mutex>& guard)
+        {
+            if(next_chunk >= chunks)
+                return false;
+
+            int chunk = next_chunk++;
+
+            int start = chunk * per_chunk;
+            int fin = std::min(count, start + per_chunk);
+
+            guard.unlock();
+
+            (*func)(start, fin);
+
+            guard.lock();
+
+            remaining--;
+
+            if(remaining == 0)
+                done_cv.notify_all();
+
+            return true;
+        }
+
+        void run()
+        {
+            std::unique_lock guard(lock);
+
+            while(1)
+            {
+                work_cv.wait(guard, [&](){return quit || next_chunk < chunks;});
+
+                if(quit)
+                    return;
+
+                run_one(guard);
+            }
+        }
+
+        ///splits [0, _count) across the workers, and waits for them
+        void parallel_for(int _count, const std::function<void(int, int)>& _func)
+        {
+            int workers = std::min((int)threads.size() + 1, _count);
+
+            if(workers <= 1)
+            {
+                _func(0, _count);
+                return;
+            }
+
+            std::lock_guard call_guard(call_lock);
+
+            std::unique_lock guard(lock);
+
+            func = &_func;
+            count = _count;
+            per_chunk = (count + workers - 1) / workers;
+            chunks = (count + per_chunk - 1) / per_chunk;
+            next_chunk = 0;
+            remaining = chunks;
+
+            work_cv.notify_all();
+
+            while(run_one(guard)){}
+
+            done_cv.wait(guard, [&](){return remaining == 0;});
+
+            func = nullptr;
+            chunks = 0;
+            next_chunk = 0;
+        }
+    };
+
+    void parallel_for(int count, const std::function<void(int, int)>& func)
+    {
+        static blur_pool pool;
+
+        pool.parallel_for(count, func);
+    }
+
+    ///running sum box filter along one line of rgba8 texels, so the cost doesn't depend on the radius
+    ///the channels are kept in separate lanes, which the compiler can vectorise
+    void box_blur_line(const uint8_t* in, uint8_t* out, int len, int stride, int radius)
+    {
+        uint32_t window = radius * 2 + 1;
+        uint32_t sum[4] = {};
+
+        auto at = [&](int idx)
+        {
+            return &in[(size_t)std::clamp(idx, 0, len - 1) * stride * 4];
+        };
+
+        for(int k=-radius; k <= radius; k++)
+        {
+            const uint8_t* texel = at(k);
+
+            for(int c=0; c < 4; c++)
+                sum[c] += texel[c];
+        }
+
+        for(int i=0; i < len; i++)
+        {
+            uint8_t* dst = &out[(size_t)i * stride * 4];
+
+            for(int c=0; c < 4; c++)
+                dst[c] = (sum[c] + window / 2) / window;
+
+            const uint8_t* add = at(i + radius + 1);
+            const uint8_t* sub = at(i - radius);
+
+            for(int c=0; c < 4; c++)
+                sum[c] += add[c] - sub[c];
+        }
+    }
+
+    ///three box passes approximate a gaussian
+    void box_blur(std::vector<uint8_t>& pixels, std::vector<uint8_t>& scratch, vec2i dim, int radius, int passes)
+    {
+        scratch.resize(pixels.size());
+
+        for(int p=0; p < passes; p++)
+        {
+            parallel_for(dim.y(), [&](int start, int fin)
+            {
+                for(int y=start; y < fin; y++)
+                {
+                    size_t offset = (size_t)y * dim.x() * 4;
+
+                    box_blur_line(&pixels[offset], &scratch[offset], dim.x(), 1, radius);
+                }
+            });
+
+            parallel_for(dim.x(), [&](int start, int fin)
+            {
+                for(int x=start; x < fin; x++)
+                {
+                    size_t offset = (size_t)x * 4;
+
+                    box_blur_line(&scratch[offset], &pixels[offset], dim.y(), dim.x(), radius);
+                }
+            });
+        }
+    }
+}
+
+struct frost_renderer::gl_data
+{
+    gl_shader downsample;
+    gl_shader upsample;
+
+    vec2i screen_dim;
+
+    std::vector<render_target> down;
+    std::vector<render_target> up;
+
+    bool load()
+    {
+        return downsample.load(downsample_source) && upsample.load(upsample_source);
+    }
+
+    void resize(vec2i dim)
+    {
+        if(dim == screen_dim && down.size() > 0)
+            return;
+
+        screen_dim = dim;
+
+        for(render_target& rt : down)
+            rt.destroy();
+
+        for(render_target& rt : up)
+            rt.destroy();
+
+        down.clear();
+        up.clear();
+
+        vec2i next = dim;
+
+        for(int i=0; i < gl_frost_levels; i++)
+        {
+            next = max(next / 2, (vec2i){1, 1});
+
+            down.emplace_back().create(next);
+
+            if(i != gl_frost_levels - 1)
+                up.emplace_back().create(next);
+        }
+    }
+
+    void pass(gl_shader& shader, render_target& src, render_target& dst)
+    {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst.fbo);
+        glViewport(0, 0, dst.dim.x(), dst.dim.y());
+
+        glBindTexture(GL_TEXTURE_2D, src.tex);
+
+        shader.set_uniform("texel", (vec2f){1.f / src.dim.x(), 1.f / src.dim.y()});
+
+        shader.draw_fullscreen();
+    }
+
+    void render(unsigned int screen_fbo, const std::vector<frost_rect>& rects)
+    {
+        ///the first halving is a plain linear blit, straight out of the screen
+        blit(screen_fbo, screen_dim, down[0].fbo, down[0].dim);
+
+        downsample.bind();
+        downsample.set_uniform("tex", 0);
+        downsample.set_uniform("offset", 1.f);
+
+        for(int i=1; i < (int)down.size(); i++)
+        {
+            pass(downsample, down[i-1], down[i]);
+        }
+
+        upsample.bind();
+        upsample.set_uniform("tex", 0);
+        upsample.set_uniform("offset", 1.f);
+
+        for(int i=(int)up.size() - 1; i >= 0; i--)
+        {
+            render_target& src = i == (int)up.size() - 1 ? down.back() : up[i+1];
+
+            pass(upsample, src, up[i]);
+        }
+
+        render_target& blurred = up.size() > 0 ? up[0] : down[0];
+
+        composite(blurred.fbo, blurred.dim, screen_fbo, screen_dim, rects);
+    }
+
+    ~gl_data()
+    {
+        for(render_target& rt : down)
+            rt.destroy();
+
+        for(render_target& rt : up)
+            rt.destroy();
+    }
+};
+
+struct frost_renderer::cpu_data
+{
+    vec2i screen_dim;
+
+    ///the screen is halved twice by the gpu, and only the quarter size image is read back
+    render_target half;
+    render_target quarter;
+
+    std::vector<uint8_t> pixels;
+    std::vector<uint8_t> scratch;
+
+    void resize(vec2i dim)
+    {
+        if(dim == screen_dim && quarter.fbo != 0)
+            return;
+
+        screen_dim = dim;
+
+        half.create(max(dim / 2, (vec2i){1, 1}));
+        quarter.create(max(dim / 4, (vec2i){1, 1}));
+    }
+
+    void render(unsigned int screen_fbo, const std::vector<frost_rect>& rects)
+    {
+        blit(screen_fbo, screen_dim, half.fbo, half.dim);
+        blit(half.fbo, half.dim, quarter.fbo, quarter.dim);
+
+        vec2i dim = quarter.dim;
+
+        pixels.resize((size_t)dim.x() * dim.y() * 4);
+
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, quarter.fbo);
+        glReadPixels(0, 0, dim.x(), dim.y(), GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+        box_blur(pixels, scratch, dim, 3, 3);
+
+        glBindTexture(GL_TEXTURE_2D, quarter.tex);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, dim.x(), dim.y(), GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+        composite(quarter.fbo, quarter.dim, screen_fbo, screen_dim, rects);
+    }
+
+    ~cpu_data()
+    {
+        half.destroy();
+        quarter.destroy();
+    }
+};
+
+#ifndef NO_OPENCL
+#ifndef NO_OPENCL_SCREEN
+///unconditionally blur whole screen once into a downsampled chain, then only composite the bits we want
+static
+void blur_buffer(render_window& win, cl::gl_rendertexture& tex, const std::vector<frost_rect>& frosty)
+{
+    opencl_context& clctx = *win.clctx;
+
+    std::vector<cl_int4> rects;
+
+    vec2i bound_min = win.get_window_size();
+    vec2i bound_max = {0, 0};
+
+    for(const frost_rect& f : frosty)
+    {
+        cl_int4 r;
+        r.s[0] = f.pos.x();
+        r.s[1] = f.pos.y();
+        r.s[2] = f.dim.x();
+        r.s[3] = f.dim.y();
+
+        rects.push_back(r);
+
+        bound_min = min(bound_min, f.pos);
+        bound_max = max(bound_max, f.pos + f.dim);
+    }
+
+    if(clctx.frost_rects.alloc_size < (int64_t)(rects.size() * sizeof(cl_int4)))
+        clctx.frost_rects.alloc(rects.size() * sizeof(cl_int4));
+
+    clctx.frost_rects.write(clctx.cqueue, rects);
+
+    tex.acquire(clctx.cqueue);
+
+    ///in source texels. Dual kawase gets a wide blur out of very few taps, as most of the work happens at low resolution
+    float offset = 1.f;
+
+    for(int i=0; i < (int)clctx.frost_down.size(); i++)
+    {
+        cl::image& dst = clctx.frost_down[i];
+
+        int dx = dst.sizes[0];
+        int dy = dst.sizes[1];
+
+        cl::args down;
+
+        if(i == 0)
+            down.push_back(tex);
+        else
+            down.push_back(clctx.frost_down[i-1]);
+
+        down.push_back(dst);
+        down.push_back(dx);
+        down.push_back(dy);
+        down.push_back(offset);
+
+        clctx.cqueue.exec("frost_downsample", down, {dx, dy}, {16, 16});
+    }
+
+    for(int i=(int)clctx.frost_up.size() - 1; i >= 0; i--)
+    {
+        cl::image& dst = clctx.frost_up[i];
+
+        int dx = dst.sizes[0];
+        int dy = dst.sizes[1];
+
+        cl::args up;
+
+        if(i == (int)clctx.frost_up.size() - 1)
+            up.push_back(clctx.frost_down.back());
+        else
+            up.push_back(clctx.frost_up[i+1]);
+
+        up.push_back(dst);
+        up.push_back(dx);
+        up.push_back(dy);
+        up.push_back(offset);
+
+        clctx.cqueue.exec("frost_upsample", up, {dx, dy}, {16, 16});
+    }
+
+    cl::image& blurred = clctx.frost_up.size() > 0 ? clctx.frost_up[0] : clctx.frost_down[0];
+
+    vec2i bound_dim = bound_max - bound_min;
+
+    cl::args composite;
+    composite.push_back(blurred);
+    composite.push_back(tex);
+    composite.push_back(clctx.frost_rects);
+    composite.push_back((int)rects.size());
+    composite.push_back(bound_dim.x());
+    composite.push_back(bound_dim.y());
+    composite.push_back(bound_min.x());
+    composite.push_back(bound_min.y());
+
+    clctx.cqueue.exec("frost_composite", composite, {bound_dim.x(), bound_dim.y()}, {16, 16});
+
+    tex.unacquire(clctx.cqueue);
+}
+#endif
+#endif // NO_OPENCL
+
+frost_renderer::frost_renderer()
+{
+
+}
+
+frost_renderer::~frost_renderer()
+{
+
+}
+
+void frost_renderer::set_backend(frost_backend::type type)
+{
+    requested = type;
+    resolved = frost_backend::AUTO;
+}
+
+frost_backend::type frost_renderer::get_backend()
+{
+    return resolved;
+}
+
+frost_backend::type frost_renderer::probe(render_window& win)
+{
+    #ifndef NO_OPENCL
+    #ifndef NO_OPENCL_SCREEN
+    ///without gl sharing the screen texture never makes it into opencl. Without both sync extensions, every acquire and release
+    ///stalls the cpu on a fence or a cl queue finish, which costs more than the shader backend does
+    if((requested == frost_backend::AUTO || requested == frost_backend::OPENCL) &&
+       win.clctx && win.clctx->has_screen_tex() && win.clctx->frost_down.size() > 0)
+    {
+        const auto& screen = win.clctx->get_screen_tex();
+
+        if(screen.sharing_is_available && screen.gl_event_is_available && GLEW_ARB_cl_event)
+            return frost_backend::OPENCL;
+    }
+    #endif
+    #endif // NO_OPENCL
+
+    if(requested == frost_backend::CPU)
+        return frost_backend::CPU;
+
+    if(!gl)
+        gl = std::make_unique<gl_data>();
+
+    if(gl->load())
+        return frost_backend::GL;
+
+    gl.reset();
+
+    return frost_backend::CPU;
+}
+
+void frost_renderer::render(render_window& win, const std::vector<frostable>& frosty)
+{
+    if(frosty.size() == 0 || requested == frost_backend::NONE)
+        return;
+
+    ///an explicitly requested backend that isn't available degrades, rather than disabling frost
+    if(resolved == frost_backend::AUTO)
+        resolved = probe(win);
+
+    vec2i screen_dim = win.get_window_size();
+
+    std::vector<frost_rect> rects = to_gl_rects(frosty, screen_dim);
+
+    if(rects.size() == 0)
+        return;
+
+    #ifndef NO_OPENCL
+    #ifndef NO_OPENCL_SCREEN
+    if(resolved == frost_backend::OPENCL)
+    {
+        blur_buffer(win, win.clctx->get_screen_tex(), rects);
+        return;
+    }
+    #endif
+    #endif // NO_OPENCL
+
+    gl_state_saver saver;
+
+    unsigned int screen_fbo = saver.draw_fbo;
+
+    if(resolved == frost_backend::GL)
+    {
+        gl->resize(screen_dim);
+        gl->render(screen_fbo, rects);
+    }
+
+    if(resolved == frost_backend::CPU)
+    {
+        if(!cpu)
+            cpu = std::make_unique<cpu_data>();
+
+        cpu->resize(screen_dim);
+        cpu->render(screen_fbo, rects);
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef FROST_HPP_INCLUDED
+#define FROST_HPP_INCLUDED
+
+#include "render_window.hpp"
+#include <memory>
+
+///blurs the frosted window rects of the currently bound draw framebuffer, from inside an imgui draw callback
+///AUTO probes for opencl gl sharing first, then a glsl blur, and falls back to blurring a downsampled readback on the cpu
+struct frost_renderer
+{
+    frost_renderer();
+    ~frost_renderer();
+
+    frost_renderer(const frost_renderer&) = delete;
+    frost_renderer& operator=(const frost_renderer&) = delete;
+
+    ///AUTO causes the next render to probe again
+    void set_backend(frost_backend::type type);
+
+    ///the backend in use, once resolved. AUTO until the first render
+    frost_backend::type get_backend();
+
+    ///gl thread only
+    void render(render_window& win, const std::vector<frostable>& frosty);
+
+private:
+    struct gl_data;
+    struct cpu_data;
+
+    frost_backend::type requested = frost_backend::AUTO;
+    frost_backend::type resolved = frost_backend::AUTO;
+
+    std::unique_ptr<gl_data> gl;
+    std::unique_ptr<cpu_data> cpu;
+
+    frost_backend::type probe(render_window& win);
+};
+
+#endif // FROST_HPP_INCLUDED
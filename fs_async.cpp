@@ -0,0 +1,934 @@
+#include "fs_async.hpp"
+#include "fs_pack.hpp"
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
+#include <algorithm>
+#include <unordered_set>
+#include <string_view>
+#include <string.h>
+
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+#define USE_IO_URING
+#endif
+
+#ifdef USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif // USE_IO_URING
+
+namespace
+{
+    namespace op
+    {
+        enum type
+        {
+            READ,
+            WRITE,
+            WRITE_ATOMIC,
+            EXISTS,
+            MKDIR,
+        };
+    }
+
+    struct io_request
+    {
+        op::type type = op::READ;
+        std::string path;
+        std::string data;
+        file::mode::type m = file::mode::BINARY;
+
+        ///read's contents, or write's success and exists' answer
+        std::string result;
+        bool ok = false;
+        ///answered from a write which hasn't landed yet, so there's nothing left to do
+        bool resolved = false;
+
+        std::function<void(io_request&)> complete;
+
+        #ifdef USE_IO_URING
+        int fd = -1;
+        size_t done = 0;
+        struct statx stx = {};
+        #endif // USE_IO_URING
+    };
+
+    void run_sync(io_request& r)
+    {
+        if(r.resolved)
+            return;
+
+        switch(r.type)
+        {
+            case op::READ:
+                r.result = file::read(r.path, r.m);
+                r.ok = true;
+                break;
+            case op::WRITE:
+                file::write(r.path, r.data, r.m);
+                r.ok = true;
+                break;
+            case op::WRITE_ATOMIC:
+                file::write_atomic(r.path, r.data, r.m);
+                r.ok = true;
+                break;
+            case op::EXISTS:
+                r.ok = file::exists(r.path);
+                break;
+            case op::MKDIR:
+                file::mkdir(r.path);
+                r.ok = true;
+                break;
+        }
+    }
+
+    #ifdef USE_IO_URING
+    ///just enough of io_uring to submit a batch and wait for all of it, through the raw syscalls so there's no liburing dependency
+    struct uring
+    {
+        int fd = -1;
+
+        void* sq_ptr = nullptr;
+        void* cq_ptr = nullptr;
+        size_t sq_len = 0;
+        size_t cq_len = 0;
+
+        unsigned* sq_head = nullptr;
+        unsigned* sq_tail = nullptr;
+        unsigned* sq_mask = nullptr;
+        unsigned* sq_array = nullptr;
+
+        unsigned* cq_head = nullptr;
+        unsigned* cq_tail = nullptr;
+        unsigned* cq_mask = nullptr;
+        io_uring_cqe* cqes = nullptr;
+
+        io_uring_sqe* sqes = nullptr;
+        size_t sqes_len = 0;
+
+        unsigned entries = 0;
+        unsigned queued = 0;
+
+        ///set once io_uring_enter has failed outright. Anything that wasn't submitted is stuck in the queue, so the ring can't be used again
+        bool broken = false;
+
+        std::vector<bool> supported;
+
+        bool init(unsigned requested_entries)
+        {
+            io_uring_params params = {};
+
+            fd = (int)syscall(__NR_io_uring_setup, requested_entries, &params);
+
+            ///ENOSYS on old kernels, and EPERM where seccomp or sysctl turns it off
+            if(fd < 0)
+                return false;
+
+            entries = params.sq_entries;
+
+            sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_len = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+            if(params.features & IORING_FEAT_SINGLE_MMAP)
+                sq_len = cq_len = std::max(sq_len, cq_len);
+
+            sq_ptr = mmap(nullptr, sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+
+            if(sq_ptr == MAP_FAILED)
+            {
+                sq_ptr = nullptr;
+                return false;
+            }
+
+            if(params.features & IORING_FEAT_SINGLE_MMAP)
+            {
+                cq_ptr = sq_ptr;
+            }
+            else
+            {
+                cq_ptr = mmap(nullptr, cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+
+                if(cq_ptr == MAP_FAILED)
+                {
+                    cq_ptr = nullptr;
+                    return false;
+                }
+            }
+
+            sqes_len = params.sq_entries * sizeof(io_uring_sqe);
+            void* sqe_ptr = mmap(nullptr, sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+            if(sqe_ptr == MAP_FAILED)
+                return false;
+
+            sqes = (io_uring_sqe*)sqe_ptr;
+
+            char* sq = (char*)sq_ptr;
+            char* cq = (char*)cq_ptr;
+
+            sq_head = (unsigned*)(sq + params.sq_off.head);
+            sq_tail = (unsigned*)(sq + params.sq_off.tail);
+            sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+            sq_array = (unsigned*)(sq + params.sq_off.array);
+
+            cq_head = (unsigned*)(cq + params.cq_off.head);
+            cq_tail = (unsigned*)(cq + params.cq_off.tail);
+            cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+            cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+            return probe();
+        }
+
+        bool probe()
+        {
+            size_t probe_len = sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op);
+
+            std::vector<char> storage(probe_len, 0);
+            io_uring_probe* pr = (io_uring_probe*)storage.data();
+
+            if(syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, pr, IORING_OP_LAST) < 0)
+                return false;
+
+            supported.resize(IORING_OP_LAST);
+
+            for(int i=0; i < (int)pr->ops_len && i < IORING_OP_LAST; i++)
+            {
+                supported[pr->ops[i].op] = (pr->ops[i].flags & IO_URING_OP_SUPPORTED) != 0;
+            }
+
+            return is_supported(IORING_OP_OPENAT) && is_supported(IORING_OP_STATX) && is_supported(IORING_OP_READ) &&
+                   is_supported(IORING_OP_WRITE) && is_supported(IORING_OP_CLOSE);
+        }
+
+        bool is_supported(int opcode)
+        {
+            return opcode < (int)supported.size() && supported[opcode];
+        }
+
+        ~uring()
+        {
+            if(sqes)
+                munmap(sqes, sqes_len);
+
+            if(cq_ptr && cq_ptr != sq_ptr)
+                munmap(cq_ptr, cq_len);
+
+            if(sq_ptr)
+                munmap(sq_ptr, sq_len);
+
+            if(fd >= 0)
+                close(fd);
+        }
+
+        ///nullptr once the submission queue is full
+        io_uring_sqe* get_sqe()
+        {
+            if(queued >= entries)
+                return nullptr;
+
+            unsigned tail = *sq_tail + queued;
+            unsigned index = tail & *sq_mask;
+
+            io_uring_sqe* sqe = &sqes[index];
+            memset(sqe, 0, sizeof(io_uring_sqe));
+
+            sq_array[index] = index;
+            queued++;
+
+            return sqe;
+        }
+
+        ///submits everything queued, and calls func(user_data, res) for every completion
+        ///false if io_uring_enter fails outright. What the kernel had already taken is still waited for, as it completes into the requests' memory
+        template<typename T>
+        bool submit_and_wait(T&& func)
+        {
+            unsigned count = queued;
+
+            if(count == 0)
+                return !broken;
+
+            if(broken)
+                return false;
+
+            __atomic_store_n(sq_tail, *sq_tail + count, __ATOMIC_RELEASE);
+            queued = 0;
+
+            unsigned completed = 0;
+            unsigned to_submit = count;
+            unsigned expected = count;
+
+            while(completed < expected)
+            {
+                int rval = (int)syscall(__NR_io_uring_enter, fd, broken ? 0 : to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+                if(rval < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                {
+                    ///failing to even wait leaves nothing else to try
+                    if(broken)
+                        return false;
+
+                    broken = true;
+                    expected = count - to_submit;
+                    continue;
+                }
+
+                if(rval > 0 && !broken)
+                    to_submit -= std::min((unsigned)rval, to_submit);
+
+                unsigned head = *cq_head;
+                unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+
+                while(head != tail)
+                {
+                    io_uring_cqe& cqe = cqes[head & *cq_mask];
+
+                    func(cqe.user_data, cqe.res);
+
+                    head++;
+                    completed++;
+                }
+
+                __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+            }
+
+            return !broken;
+        }
+    };
+
+    void prep(io_uring_sqe* sqe, int opcode, int fd, const void* addr, unsigned len, uint64_t offset, uint64_t user_data)
+    {
+        sqe->opcode = opcode;
+        sqe->fd = fd;
+        sqe->addr = (uint64_t)(uintptr_t)addr;
+        sqe->len = len;
+        sqe->off = offset;
+        sqe->user_data = user_data;
+    }
+
+    ///once the ring has failed there's no telling how far each request got, so none of the chunk is reported as done
+    void fail_chunk(std::vector<io_request*>& chunk)
+    {
+        for(io_request* r : chunk)
+        {
+            if(r->fd >= 0)
+                close(r->fd);
+
+            r->fd = -1;
+            r->ok = false;
+            r->result.clear();
+        }
+    }
+
+    ///a chunk has to fit in the ring in one go, at two entries per request in the first phase
+    ///requests carry their index in the chunk as user_data, with the top half set for statx. Anything else is ignored rather than trusted
+    void run_uring_chunk(uring& ring, std::vector<io_request*>& chunk)
+    {
+        ///open and statx by path, so both go in one submission
+        for(int i=0; i < (int)chunk.size(); i++)
+        {
+            io_request& r = *chunk[i];
+
+            if(r.type == op::READ || r.type == op::WRITE)
+            {
+                int flags = r.type == op::READ ? (O_RDONLY | O_CLOEXEC) : (O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC);
+
+                io_uring_sqe* sqe = ring.get_sqe();
+                prep(sqe, IORING_OP_OPENAT, AT_FDCWD, r.path.c_str(), 0666, 0, i);
+                sqe->open_flags = flags;
+            }
+
+            if(r.type == op::READ || r.type == op::EXISTS)
+            {
+                io_uring_sqe* sqe = ring.get_sqe();
+                prep(sqe, IORING_OP_STATX, AT_FDCWD, r.path.c_str(), STATX_SIZE, (uint64_t)(uintptr_t)&r.stx, ((uint64_t)1 << 32) | i);
+                sqe->statx_flags = AT_STATX_SYNC_AS_STAT;
+            }
+
+            if(r.type == op::MKDIR)
+            {
+                io_uring_sqe* sqe = ring.get_sqe();
+                prep(sqe, IORING_OP_MKDIRAT, AT_FDCWD, r.path.c_str(), 0777, 0, i);
+            }
+        }
+
+        std::vector<int> stat_results(chunk.size(), -1);
+
+        bool ok = ring.submit_and_wait([&](uint64_t user_data, int res)
+        {
+            uint64_t idx = user_data & 0xffffffff;
+            uint64_t tag = user_data >> 32;
+
+            if(idx >= chunk.size() || tag > 1)
+                return;
+
+            bool is_stat = tag == 1;
+
+            io_request& r = *chunk[idx];
+
+            if(is_stat)
+            {
+                stat_results[idx] = res;
+
+                if(r.type == op::EXISTS)
+                    r.ok = res == 0;
+
+                return;
+            }
+
+            if(r.type == op::MKDIR)
+            {
+                r.ok = res == 0 || res == -EEXIST;
+                return;
+            }
+
+            r.fd = res >= 0 ? res : -1;
+        });
+
+        if(!ok)
+        {
+            fail_chunk(chunk);
+            return;
+        }
+
+        for(int i=0; i < (int)chunk.size(); i++)
+        {
+            io_request& r = *chunk[i];
+
+            if(r.type == op::READ && r.fd >= 0 && stat_results[i] == 0)
+                r.result.resize(r.stx.stx_size);
+        }
+
+        ///short reads and writes get resubmitted from where they stopped
+        while(1)
+        {
+            for(int i=0; i < (int)chunk.size(); i++)
+            {
+                io_request& r = *chunk[i];
+
+                if(r.fd < 0 || (r.type != op::READ && r.type != op::WRITE))
+                    continue;
+
+                size_t total = r.type == op::READ ? r.result.size() : r.data.size();
+
+                if(r.done >= total)
+                    continue;
+
+                unsigned len = (unsigned)std::min(total - r.done, (size_t)1 << 30);
+
+                io_uring_sqe* sqe = ring.get_sqe();
+
+                if(r.type == op::READ)
+                    prep(sqe, IORING_OP_READ, r.fd, r.result.data() + r.done, len, r.done, i);
+                else
+                    prep(sqe, IORING_OP_WRITE, r.fd, r.data.data() + r.done, len, r.done, i);
+            }
+
+            if(ring.queued == 0)
+                break;
+
+            ok = ring.submit_and_wait([&](uint64_t user_data, int res)
+            {
+                if(user_data >= chunk.size())
+                    return;
+
+                io_request& r = *chunk[user_data];
+
+                ///an error, or a file which shrank since it was statted
+                if(res <= 0)
+                {
+                    if(r.type == op::READ && res == 0)
+                        r.result.resize(r.done);
+                    else
+                        r.ok = false;
+
+                    if(r.type == op::READ && res < 0)
+                        r.result.clear();
+
+                    r.done = r.type == op::READ ? r.result.size() : r.data.size();
+
+                    if(res < 0)
+                    {
+                        close(r.fd);
+                        r.fd = -1;
+                    }
+
+                    return;
+                }
+
+                r.done += res;
+            });
+
+            if(!ok)
+            {
+                fail_chunk(chunk);
+                return;
+            }
+        }
+
+        for(int i=0; i < (int)chunk.size(); i++)
+        {
+            io_request& r = *chunk[i];
+
+            if(r.type == op::READ)
+                r.ok = true;
+
+            if(r.type == op::WRITE)
+                r.ok = r.fd >= 0;
+
+            if(r.fd < 0)
+                continue;
+
+            io_uring_sqe* sqe = ring.get_sqe();
+            prep(sqe, IORING_OP_CLOSE, r.fd, nullptr, 0, 0, i);
+        }
+
+        ok = ring.submit_and_wait([&](uint64_t user_data, int res)
+        {
+            (void)res;
+
+            if(user_data >= chunk.size())
+                return;
+
+            chunk[user_data]->fd = -1;
+        });
+
+        ///the requests are all done by now, but an fd whose close never completed would leak
+        if(!ok)
+        {
+            for(io_request* r : chunk)
+            {
+                if(r->fd >= 0)
+                    close(r->fd);
+
+                r->fd = -1;
+            }
+        }
+    }
+
+    void run_uring(uring& ring, std::vector<io_request>& batch)
+    {
+        std::vector<io_request*> chunk;
+        ///requests within a chunk run in any order, so a path only goes in once, and a second request for it starts a new chunk
+        std::unordered_set<std::string_view> chunk_paths;
+
+        auto flush = [&]()
+        {
+            if(chunk.size() > 0)
+                run_uring_chunk(ring, chunk);
+
+            chunk.clear();
+            chunk_paths.clear();
+        };
+
+        for(io_request& r : batch)
+        {
+            if(r.resolved)
+                continue;
+
+            ///the synchronous functions check mounted packs themselves, but the ring goes straight to the os
+            if(r.type == op::READ)
+            {
+                if(std::optional<std::string> packed = file::pack::read(r.path))
+                {
+                    r.result = std::move(packed.value());
+                    r.ok = true;
+                    continue;
+                }
+            }
+
+            if(r.type == op::EXISTS && file::pack::exists(r.path))
+            {
+                r.ok = true;
+                continue;
+            }
+
+            if(chunk_paths.count(r.path) > 0)
+                flush();
+
+            ///the requester's held back writes were checked when the request was made, but a background write of one can still be landing
+            if(r.type == op::READ || r.type == op::EXISTS)
+            {
+                if(std::optional<std::string> pending = file::pending::find(r.path))
+                {
+                    if(r.type == op::READ)
+                        r.result = std::move(pending.value());
+
+                    r.ok = true;
+                    continue;
+                }
+            }
+
+            if(r.type == op::WRITE)
+                file::pending::wait_for(r.path);
+
+            ///write_atomic's rename dance, and mkdir on kernels before 5.15, stay synchronous. So does everything once the ring has failed
+            if(ring.broken || r.type == op::WRITE_ATOMIC || (r.type == op::MKDIR && !ring.is_supported(IORING_OP_MKDIRAT)))
+            {
+                run_sync(r);
+                continue;
+            }
+
+            chunk.push_back(&r);
+            chunk_paths.insert(r.path);
+
+            if(chunk.size() * 2 >= ring.entries)
+                flush();
+        }
+
+        flush();
+    }
+    #endif // USE_IO_URING
+
+    struct engine
+    {
+        std::mutex lock;
+        std::condition_variable cv;
+        std::deque<io_request> queue;
+        std::vector<std::thread> threads;
+        bool quit = false;
+
+        ///paths a pool thread is working on. Requests for them wait, so that requests to one path run and complete in the order they were made
+        std::unordered_set<std::string> busy;
+
+        #ifdef USE_IO_URING
+        std::unique_ptr<uring> ring;
+        #endif // USE_IO_URING
+
+        engine()
+        {
+            #ifndef __EMSCRIPTEN__
+            #ifdef USE_IO_URING
+            ring = std::make_unique<uring>();
+
+            if(!ring->init(256))
+                ring.reset();
+
+            ///one thread drains everything that's queued into a single submission
+            if(ring)
+            {
+                threads.emplace_back([this](){run_ring();});
+                return;
+            }
+            #endif // USE_IO_URING
+
+            int count = std::clamp((int)std::thread::hardware_concurrency(), 1, 4);
+
+            for(int i=0; i < count; i++)
+            {
+                threads.emplace_back([this](){run_pool();});
+            }
+            #endif // __EMSCRIPTEN__
+        }
+
+        ~engine()
+        {
+            {
+                std::lock_guard guard(lock);
+                quit = true;
+            }
+
+            cv.notify_all();
+
+            for(std::thread& t : threads)
+            {
+                t.join();
+            }
+        }
+
+        void add(std::vector<io_request>&& reqs)
+        {
+            #ifdef __EMSCRIPTEN__
+            for(io_request& r : reqs)
+            {
+                run_sync(r);
+                r.complete(r);
+            }
+            #else
+            {
+                std::lock_guard guard(lock);
+
+                for(io_request& r : reqs)
+                {
+                    queue.push_back(std::move(r));
+                }
+            }
+
+            cv.notify_all();
+            #endif // __EMSCRIPTEN__
+        }
+
+        #ifdef USE_IO_URING
+        void run_ring()
+        {
+            while(1)
+            {
+                std::vector<io_request> batch;
+
+                {
+                    std::unique_lock guard(lock);
+
+                    cv.wait(guard, [&](){return quit || queue.size() > 0;});
+
+                    if(queue.size() == 0)
+                        return;
+
+                    while(queue.size() > 0)
+                    {
+                        batch.push_back(std::move(queue.front()));
+                        queue.pop_front();
+                    }
+                }
+
+                run_uring(*ring, batch);
+
+                for(io_request& r : batch)
+                {
+                    r.complete(r);
+                }
+            }
+        }
+        #endif // USE_IO_URING
+
+        ///the first request whose path isn't busy. An earlier request for the same path would have been found first, so this keeps the order per path
+        std::deque<io_request>::iterator next_runnable()
+        {
+            return std::find_if(queue.begin(), queue.end(), [&](const io_request& r){return busy.count(r.path) == 0;});
+        }
+
+        void run_pool()
+        {
+            while(1)
+            {
+                io_request r;
+
+                {
+                    std::unique_lock guard(lock);
+
+                    cv.wait(guard, [&](){return (quit && queue.size() == 0) || next_runnable() != queue.end();});
+
+                    if(queue.size() == 0)
+                        return;
+
+                    auto it = next_runnable();
+
+                    r = std::move(*it);
+                    queue.erase(it);
+
+                    busy.insert(r.path);
+                }
+
+                run_sync(r);
+                r.complete(r);
+
+                {
+                    std::lock_guard guard(lock);
+                    busy.erase(r.path);
+                }
+
+                cv.notify_all();
+            }
+        }
+    };
+
+    engine& get_engine()
+    {
+        static engine eng;
+
+        return eng;
+    }
+
+    thread_local int batches = 0;
+    thread_local std::vector<io_request> batched;
+
+    ///the io threads can't see this thread's held back writes, so whatever would race one is settled here, on the thread making the request
+    void consult_pending(io_request& r)
+    {
+        if((r.type == op::READ || r.type == op::EXISTS) && !file::pack::exists(r.path))
+        {
+            if(std::optional<std::string> pending = file::pending::find(r.path))
+            {
+                if(r.type == op::READ)
+                    r.result = std::move(pending.value());
+
+                r.ok = true;
+                r.resolved = true;
+            }
+        }
+
+        if(r.type == op::WRITE || r.type == op::WRITE_ATOMIC)
+            file::pending::supersede(r.path);
+    }
+
+    void submit(io_request&& r)
+    {
+        consult_pending(r);
+
+        if(batches > 0)
+        {
+            batched.push_back(std::move(r));
+            return;
+        }
+
+        std::vector<io_request> single;
+        single.push_back(std::move(r));
+
+        get_engine().add(std::move(single));
+    }
+
+    io_request make(op::type type, const std::string& path, file::mode::type m)
+    {
+        io_request r;
+        r.type = type;
+        r.path = path;
+        r.m = m;
+
+        return r;
+    }
+}
+
+file::async::batch::batch()
+{
+    batches++;
+}
+
+file::async::batch::~batch()
+{
+    batches--;
+
+    if(batches == 0 && batched.size() > 0)
+    {
+        std::vector<io_request> reqs = std::move(batched);
+        batched.clear();
+
+        get_engine().add(std::move(reqs));
+    }
+}
+
+bool file::async::is_io_uring()
+{
+    #ifdef USE_IO_URING
+    return get_engine().ring != nullptr;
+    #else
+    return false;
+    #endif
+}
+
+void file::async::read(const std::string& file, file::mode::type m, std::function<void(std::string)> on_complete)
+{
+    io_request r = make(op::READ, file, m);
+
+    r.complete = [on_complete = std::move(on_complete)](io_request& r)
+    {
+        on_complete(std::move(r.result));
+    };
+
+    submit(std::move(r));
+}
+
+void file::async::write(const std::string& file, std::string data, file::mode::type m, std::function<void(bool)> on_complete)
+{
+    io_request r = make(op::WRITE, file, m);
+    r.data = std::move(data);
+
+    r.complete = [on_complete = std::move(on_complete)](io_request& r)
+    {
+        on_complete(r.ok);
+    };
+
+    submit(std::move(r));
+}
+
+std::future<std::string> file::async::read(const std::string& file, file::mode::type m)
+{
+    auto promise = std::make_shared<std::promise<std::string>>();
+
+    std::future<std::string> ret = promise->get_future();
+
+    read(file, m, [promise](std::string result)
+    {
+        promise->set_value(std::move(result));
+    });
+
+    return ret;
+}
+
+std::future<bool> file::async::write(const std::string& file, std::string data, file::mode::type m)
+{
+    auto promise = std::make_shared<std::promise<bool>>();
+
+    std::future<bool> ret = promise->get_future();
+
+    write(file, std::move(data), m, [promise](bool ok)
+    {
+        promise->set_value(ok);
+    });
+
+    return ret;
+}
+
+std::future<void> file::async::write_atomic(const std::string& file, std::string data, file::mode::type m)
+{
+    auto promise = std::make_shared<std::promise<void>>();
+
+    std::future<void> ret = promise->get_future();
+
+    io_request r = make(op::WRITE_ATOMIC, file, m);
+    r.data = std::move(data);
+
+    r.complete = [promise](io_request& r)
+    {
+        (void)r;
+        promise->set_value();
+    };
+
+    submit(std::move(r));
+
+    return ret;
+}
+
+std::future<bool> file::async::exists(const std::string& name)
+{
+    auto promise = std::make_shared<std::promise<bool>>();
+
+    std::future<bool> ret = promise->get_future();
+
+    io_request r = make(op::EXISTS, name, file::mode::BINARY);
+
+    r.complete = [promise](io_request& r)
+    {
+        promise->set_value(r.ok);
+    };
+
+    submit(std::move(r));
+
+    return ret;
+}
+
+std::future<void> file::async::mkdir(const std::string& name)
+{
+    auto promise = std::make_shared<std::promise<void>>();
+
+    std::future<void> ret = promise->get_future();
+
+    io_request r = make(op::MKDIR, name, file::mode::BINARY);
+
+    r.complete = [promise](io_request& r)
+    {
+        (void)r;
+        promise->set_value();
+    };
+
+    submit(std::move(r));
+
+    return ret;
+}
@@ -0,0 +1,43 @@
+#ifndef FS_ASYNC_HPP_INCLUDED
+#define FS_ASYNC_HPP_INCLUDED
+
+#include "fs_helpers.hpp"
+#include <string>
+#include <future>
+#include <functional>
+
+///the fs_helpers functions, run off the calling thread. Paths are the same as for file::, and web/ is still prefixed under emscripten
+///on linux requests go through io_uring where the kernel allows it, and everything queued at once is submitted together
+///otherwise a small thread pool runs the synchronous versions. Emscripten completes everything immediately on the calling thread
+namespace file
+{
+    namespace async
+    {
+        std::future<std::string> read(const std::string& file, mode::type m);
+        ///the future is false if the file couldn't be written
+        std::future<bool> write(const std::string& file, std::string data, mode::type m);
+        std::future<void> write_atomic(const std::string& file, std::string data, mode::type m);
+        std::future<bool> exists(const std::string& name);
+        std::future<void> mkdir(const std::string& name);
+
+        ///the callback runs on an io thread, so it should hand anything expensive on
+        void read(const std::string& file, mode::type m, std::function<void(std::string)> on_complete);
+        void write(const std::string& file, std::string data, mode::type m, std::function<void(bool)> on_complete);
+
+        ///requests made on this thread while a batch is alive are held back, and queued together when the outermost batch ends
+        ///eg loading a directory of configs is then one submission, rather than one per file
+        struct batch
+        {
+            batch();
+            ~batch();
+
+            batch(const batch&) = delete;
+            batch& operator=(const batch&) = delete;
+        };
+
+        ///whether requests are going through io_uring, rather than the thread pool
+        bool is_io_uring();
+    }
+}
+
+#endif // FS_ASYNC_HPP_INCLUDED
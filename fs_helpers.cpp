@@ -1,6 +1,7 @@
 #include "fs_helpers.hpp"
 
 #include "clock.hpp"
+#include "fs_pack.hpp"
 
 #include <string>
 #include <vector>
@@ -9,6 +10,16 @@
 #include <atomic>
 #include <stdlib.h>
 #include <optional>
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <future>
+#include <errno.h>
+#include <string.h>
 
 #ifdef __WIN32__
 #define WIN32_LEAN_AND_MEAN
@@ -19,6 +30,10 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <dirent.h>
+#ifndef __EMSCRIPTEN__
+#include <sys/mman.h>
+#endif // __EMSCRIPTEN__
 #endif // __WIN32__
 
 #ifdef __EMSCRIPTEN__
@@ -26,6 +41,8 @@
 #include <emscripten/fetch.h>
 #endif // __EMSCRIPTEN__
 
+#include <tinydir/tinydir.h>
+
 #ifdef __EMSCRIPTEN__
 EM_JS(void, syncer, (),
 {
@@ -41,6 +58,403 @@ namespace
     #ifdef __EMSCRIPTEN__
     thread_local bool syncs_dirty = false;
     #endif
+
+    std::string directory_of(const std::string& file)
+    {
+        size_t pos = file.find_last_of("/\\");
+
+        if(pos == std::string::npos)
+            return ".";
+
+        if(pos == 0)
+            return "/";
+
+        return file.substr(0, pos);
+    }
+
+    std::string filename_of(const std::string& file)
+    {
+        size_t pos = file.find_last_of("/\\");
+
+        if(pos == std::string::npos)
+            return file;
+
+        return file.substr(pos + 1);
+    }
+
+    ///eg dir/ names dir, rather than an empty name inside it
+    std::string strip_trailing_separators(std::string file)
+    {
+        while(file.size() > 1 && (file.back() == '/' || file.back() == '\\'))
+            file.pop_back();
+
+        return file;
+    }
+
+    ///windows paths are case insensitive, and take either separator
+    std::string cache_key(std::string name)
+    {
+        #ifdef __WIN32__
+        for(char& c : name)
+        {
+            if(c == '\\')
+                c = '/';
+            else
+                c = std::tolower((unsigned char)c);
+        }
+        #endif // __WIN32__
+
+        return name;
+    }
+
+    thread_local int directory_caches = 0;
+    ///directory -> the names in it, and whether each is a directory. Paths are as the os sees them, eg with web/, and both are cache_keys
+    ///whether a name is a directory is nullopt until something asks, if the listing didn't say
+    thread_local std::unordered_map<std::string, std::unordered_map<std::string, std::optional<bool>>> cached_directories;
+
+    ///called for anything this thread changes on disk, so that a directory_cache doesn't hide it. Takes an unprefixed path
+    void forget_cached(const std::string& file)
+    {
+        if(directory_caches == 0)
+            return;
+
+        #ifndef __EMSCRIPTEN__
+        cached_directories.erase(cache_key(directory_of(strip_trailing_separators(file))));
+        #else
+        cached_directories.erase(cache_key(directory_of(strip_trailing_separators("web/" + file))));
+        #endif
+    }
+
+    ///lists a directory once per directory_cache, by name only, so nothing in it gets statted. A directory which can't be opened lists as empty
+    std::unordered_map<std::string, std::optional<bool>>& list_cached(const std::string& dir)
+    {
+        std::string key = cache_key(dir);
+
+        auto it = cached_directories.find(key);
+
+        if(it != cached_directories.end())
+            return it->second;
+
+        std::unordered_map<std::string, std::optional<bool>>& names = cached_directories[key];
+
+        #ifdef __WIN32__
+        ///the find data already says which are directories
+        tinydir_dir listing;
+
+        if(tinydir_open(&listing, dir.c_str()) == -1)
+            return names;
+
+        while(listing.has_next)
+        {
+            tinydir_file f;
+
+            if(tinydir_readfile(&listing, &f) != -1)
+                names[cache_key(f.name)] = f.is_dir;
+
+            tinydir_next(&listing);
+        }
+
+        tinydir_close(&listing);
+        #else
+        ///tinydir_readfile stats every entry, where d_type usually says all that's needed
+        DIR* listing = opendir(dir.c_str());
+
+        if(listing == nullptr)
+            return names;
+
+        while(dirent* entry = readdir(listing))
+        {
+            std::optional<bool> is_dir;
+
+            #ifdef DT_DIR
+            if(entry->d_type == DT_DIR)
+                is_dir = true;
+            else if(entry->d_type != DT_UNKNOWN && entry->d_type != DT_LNK)
+                is_dir = false;
+            #endif // DT_DIR
+
+            names[cache_key(entry->d_name)] = is_dir;
+        }
+
+        closedir(listing);
+        #endif // __WIN32__
+
+        return names;
+    }
+
+    ///answers from the directory_cache. nullopt if it doesn't exist, otherwise whether it's a directory
+    std::optional<bool> find_cached(const std::string& name)
+    {
+        #ifndef __EMSCRIPTEN__
+        std::string file = strip_trailing_separators(name);
+        #else
+        std::string file = strip_trailing_separators("web/" + name);
+        #endif
+
+        std::string filename = filename_of(file);
+
+        ///the root isn't listed in anything
+        if(filename.size() == 0)
+        {
+            file::metadata meta = file::stat(name);
+
+            if(!meta.exists)
+                return std::nullopt;
+
+            return meta.is_dir;
+        }
+
+        auto& names = list_cached(directory_of(file));
+
+        auto it = names.find(cache_key(filename));
+
+        if(it == names.end())
+            return std::nullopt;
+
+        ///a symlink, or a filesystem that doesn't fill in d_type. Only these get statted, once
+        if(!it->second.has_value())
+            it->second = file::stat(name).is_dir;
+
+        return it->second;
+    }
+
+    struct unflushed_write
+    {
+        std::string data;
+        file::mode::type m = file::mode::BINARY;
+    };
+
+    ///writes made inside this thread's manual_fs_sync, by unprefixed path. Only the last write to each path is kept
+    ///shared, so that reads can hold onto the contents without a copy, even after the write lands
+    thread_local std::unordered_map<std::string, std::shared_ptr<const unflushed_write>> unflushed;
+    thread_local std::shared_ptr<std::promise<void>> unflushed_promise;
+    thread_local std::shared_future<void> unflushed_future;
+
+    void write_impl(const std::string& file, const std::string& data, file::mode::type m)
+    {
+        if(m == file::mode::BINARY)
+        {
+            #ifndef __EMSCRIPTEN__
+            std::ofstream out(file, std::ios::binary);
+            #else
+            std::ofstream out("web/" + file, std::ios::binary);
+            #endif
+            out << data;
+        }
+        else if(m == file::mode::TEXT)
+        {
+            #ifndef __EMSCRIPTEN__
+            std::ofstream out(file);
+            #else
+            std::ofstream out("web/" + file);
+            #endif
+            out << data;
+        }
+    }
+
+    #ifndef __EMSCRIPTEN__
+    ///writes out ended manual_fs_syncs on a background thread, one at a time so that writes to a path land in order
+    struct write_behind
+    {
+        struct batch
+        {
+            std::vector<std::pair<std::string, std::shared_ptr<const unflushed_write>>> writes;
+            std::shared_ptr<std::promise<void>> done;
+        };
+
+        std::mutex lock;
+        std::condition_variable cv;
+        std::deque<batch> queue;
+        std::thread thread;
+        bool quit = false;
+
+        ///everything queued or being written, so that reads find it before it lands
+        std::unordered_map<std::string, std::shared_ptr<const unflushed_write>> in_flight;
+        std::atomic_int in_flight_count{0};
+
+        ~write_behind()
+        {
+            {
+                std::lock_guard guard(lock);
+                quit = true;
+            }
+
+            cv.notify_all();
+
+            if(thread.joinable())
+                thread.join();
+        }
+
+        void add(batch&& b)
+        {
+            {
+                std::lock_guard guard(lock);
+
+                for(auto& [file, w] : b.writes)
+                {
+                    in_flight[file] = w;
+                }
+
+                in_flight_count = in_flight.size();
+
+                queue.push_back(std::move(b));
+
+                if(!thread.joinable())
+                    thread = std::thread([this](){run();});
+            }
+
+            cv.notify_all();
+        }
+
+        void run()
+        {
+            while(1)
+            {
+                batch b;
+
+                {
+                    std::unique_lock guard(lock);
+
+                    cv.wait(guard, [&](){return quit || queue.size() > 0;});
+
+                    ///whatever is queued still gets written when quitting
+                    if(queue.size() == 0)
+                        return;
+
+                    b = std::move(queue.front());
+                    queue.pop_front();
+                }
+
+                for(auto& [file, w] : b.writes)
+                {
+                    write_impl(file, w->data, w->m);
+                }
+
+                {
+                    std::lock_guard guard(lock);
+
+                    for(auto& [file, w] : b.writes)
+                    {
+                        auto it = in_flight.find(file);
+
+                        ///a later batch may have written the same file again
+                        if(it != in_flight.end() && it->second == w)
+                            in_flight.erase(it);
+                    }
+
+                    in_flight_count = in_flight.size();
+                }
+
+                cv.notify_all();
+
+                b.done->set_value();
+            }
+        }
+
+        std::shared_ptr<const unflushed_write> find(const std::string& file)
+        {
+            if(in_flight_count == 0)
+                return nullptr;
+
+            std::lock_guard guard(lock);
+
+            auto it = in_flight.find(file);
+
+            if(it == in_flight.end())
+                return nullptr;
+
+            return it->second;
+        }
+
+        void wait_for(const std::string& file)
+        {
+            if(in_flight_count == 0)
+                return;
+
+            std::unique_lock guard(lock);
+
+            cv.wait(guard, [&](){return in_flight.find(file) == in_flight.end();});
+        }
+    };
+
+    write_behind& get_write_behind()
+    {
+        static write_behind wb;
+
+        return wb;
+    }
+    #endif // __EMSCRIPTEN__
+
+    ///the contents of a write which hasn't reached the disk yet, either from this thread's manual_fs_sync, or one still being flushed
+    std::shared_ptr<const unflushed_write> find_unflushed(const std::string& file)
+    {
+        auto it = unflushed.find(file);
+
+        if(it != unflushed.end())
+            return it->second;
+
+        #ifndef __EMSCRIPTEN__
+        return get_write_behind().find(file);
+        #else
+        return nullptr;
+        #endif // __EMSCRIPTEN__
+    }
+
+    ///for anything which is about to touch a file on disk directly. Writes out this thread's unflushed write to it, and waits for a background flush of it
+    ///so that the operation can't be overtaken by an older write
+    void settle_unflushed(const std::string& file)
+    {
+        auto it = unflushed.find(file);
+
+        if(it != unflushed.end())
+        {
+            write_impl(file, it->second->data, it->second->m);
+            unflushed.erase(it);
+        }
+
+        #ifndef __EMSCRIPTEN__
+        get_write_behind().wait_for(file);
+        #endif // __EMSCRIPTEN__
+    }
+
+    void flush_unflushed()
+    {
+        std::shared_ptr<std::promise<void>> done = std::move(unflushed_promise);
+        unflushed_promise.reset();
+
+        if(unflushed.size() == 0)
+        {
+            if(done)
+                done->set_value();
+
+            return;
+        }
+
+        #ifndef __EMSCRIPTEN__
+        write_behind::batch b;
+        b.done = done ? done : std::make_shared<std::promise<void>>();
+
+        for(auto& [file, w] : unflushed)
+        {
+            b.writes.push_back({file, std::move(w)});
+        }
+
+        unflushed.clear();
+
+        get_write_behind().add(std::move(b));
+        #else
+        ///no threads, so this is the batch. The single syncfs still happens afterwards
+        for(auto& [file, w] : unflushed)
+        {
+            write_impl(file, w->data, w->m);
+        }
+
+        unflushed.clear();
+
+        if(done)
+            done->set_value();
+        #endif // __EMSCRIPTEN__
+    }
 }
 
 void sync_writes()
@@ -58,6 +472,12 @@ void sync_writes()
 
 file::manual_fs_sync::manual_fs_sync()
 {
+    if(syncs == 0)
+    {
+        unflushed_promise = std::make_shared<std::promise<void>>();
+        unflushed_future = unflushed_promise->get_future().share();
+    }
+
     syncs++;
 }
 
@@ -65,9 +485,17 @@ file::manual_fs_sync::~manual_fs_sync()
 {
     syncs--;
 
+    if(syncs == 0)
+        flush_unflushed();
+
     sync_writes();
 }
 
+std::shared_future<void> file::manual_fs_sync::completion()
+{
+    return unflushed_future;
+}
+
 std::string read_impl(const std::string& file, file::mode::type m)
 {
     const char* fmode = (m == file::mode::BINARY) ? "rb" : "r";
@@ -77,37 +505,461 @@ std::string read_impl(const std::string& file, file::mode::type m)
     if(f == nullptr)
         return "";
 
-    fseek(f, 0, SEEK_END);
-    long fsize = ftell(f);
-    fseek(f, 0, SEEK_SET);
+    fseek(f, 0, SEEK_END);
+    long fsize = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    if(fsize == -1L)
+    {
+        fclose(f);
+        return "";
+    }
+
+    std::string buffer;
+    buffer.resize(fsize);
+    size_t real = fread(buffer.data(), 1, fsize, f);
+    buffer.resize(real);
+
+    fclose(f);
+
+    return buffer;
+}
+
+std::string file::read(const std::string& file, file::mode::type m)
+{
+    if(std::optional<std::string> packed = file::pack::read(file))
+        return std::move(packed.value());
+
+    if(std::shared_ptr<const unflushed_write> pending = find_unflushed(file))
+        return pending->data;
+
+    #ifndef __EMSCRIPTEN__
+    return read_impl(file, m);
+    #else
+    return read_impl("web/" + file, m);
+    #endif
+}
+
+file::mapped_file::mapped_file()
+{
+
+}
+
+file::mapped_file::~mapped_file()
+{
+    release();
+}
+
+file::mapped_file::mapped_file(mapped_file&& other)
+{
+    *this = std::move(other);
+}
+
+file::mapped_file& file::mapped_file::operator=(mapped_file&& other)
+{
+    if(this == &other)
+        return *this;
+
+    release();
+
+    len = other.len;
+    valid = other.valid;
+    mapped = other.mapped;
+    fallback = std::move(other.fallback);
+    owner = std::move(other.owner);
+
+    #ifdef __WIN32__
+    mapping_handle = other.mapping_handle;
+    other.mapping_handle = nullptr;
+    #endif // __WIN32__
+
+    ///a moved std::string may or may not keep its buffer, so the pointer is redone
+    ptr = mapped ? other.ptr : fallback.data();
+
+    other.ptr = nullptr;
+    other.len = 0;
+    other.valid = false;
+    other.mapped = false;
+
+    return *this;
+}
+
+void file::mapped_file::release()
+{
+    if(mapped && ptr != nullptr && owner == nullptr)
+    {
+        #ifdef __WIN32__
+        UnmapViewOfFile(ptr);
+        #elif !defined(__EMSCRIPTEN__)
+        munmap((void*)ptr, len);
+        #endif
+    }
+
+    #ifdef __WIN32__
+    if(mapping_handle != nullptr)
+        CloseHandle((HANDLE)mapping_handle);
+
+    mapping_handle = nullptr;
+    #endif // __WIN32__
+
+    ptr = nullptr;
+    len = 0;
+    valid = false;
+    mapped = false;
+    fallback.clear();
+    owner.reset();
+}
+
+bool file::mapped_file::is_valid() const
+{
+    return valid;
+}
+
+bool file::mapped_file::is_mapped() const
+{
+    return mapped;
+}
+
+const char* file::mapped_file::data() const
+{
+    return ptr;
+}
+
+size_t file::mapped_file::size() const
+{
+    return len;
+}
+
+std::string_view file::mapped_file::view() const
+{
+    return std::string_view(ptr, len);
+}
+
+const std::byte* file::mapped_file::bytes() const
+{
+    return (const std::byte*)ptr;
+}
+
+file::mapped_file file::map(const std::string& in_file, file::access::type hint)
+{
+    if(std::optional<mapped_file> packed = file::pack::map(in_file))
+        return std::move(packed.value());
+
+    ///a view of the pending contents, which it keeps alive
+    if(std::shared_ptr<const unflushed_write> pending = find_unflushed(in_file))
+    {
+        mapped_file ret;
+        ret.ptr = pending->data.data();
+        ret.len = pending->data.size();
+        ret.valid = true;
+        ret.mapped = true;
+        ret.owner = std::move(pending);
+        return ret;
+    }
+
+    #ifndef __EMSCRIPTEN__
+    std::string file = in_file;
+    #else
+    std::string file = "web/" + in_file;
+    #endif
+
+    mapped_file ret;
+
+    #if defined(__WIN32__)
+    (void)hint;
+
+    HANDLE handle = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if(handle != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER fsize = {};
+
+        if(GetFileSizeEx(handle, &fsize) && fsize.QuadPart == 0)
+        {
+            CloseHandle(handle);
+
+            ret.valid = true;
+            return ret;
+        }
+
+        HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        CloseHandle(handle);
+
+        if(mapping != nullptr)
+        {
+            const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+            if(view != nullptr)
+            {
+                ret.ptr = (const char*)view;
+                ret.len = fsize.QuadPart;
+                ret.valid = true;
+                ret.mapped = true;
+                ret.mapping_handle = (void*)mapping;
+                return ret;
+            }
+
+            CloseHandle(mapping);
+        }
+    }
+    #elif !defined(__EMSCRIPTEN__)
+    int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if(fd != -1)
+    {
+        struct stat st = {};
+
+        if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+        {
+            ///mmap rejects a zero length
+            if(st.st_size == 0)
+            {
+                close(fd);
+
+                ret.valid = true;
+                return ret;
+            }
+
+            void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if(view != MAP_FAILED)
+            {
+                close(fd);
+
+                int advice = MADV_NORMAL;
+
+                if(hint == file::access::SEQUENTIAL)
+                    advice = MADV_SEQUENTIAL;
+                else if(hint == file::access::RANDOM)
+                    advice = MADV_RANDOM;
+
+                madvise(view, st.st_size, advice);
+
+                ret.ptr = (const char*)view;
+                ret.len = st.st_size;
+                ret.valid = true;
+                ret.mapped = true;
+                return ret;
+            }
+        }
+
+        close(fd);
+    }
+    #else
+    (void)hint;
+    #endif
+
+    ///the file doesn't exist, or can't be mapped, eg a pipe, or on emscripten
+    FILE* f = fopen(file.c_str(), "rb");
+
+    if(f == nullptr)
+        return ret;
+
+    fclose(f);
+
+    ret.fallback = read_impl(file, file::mode::BINARY);
+    ret.ptr = ret.fallback.data();
+    ret.len = ret.fallback.size();
+    ret.valid = true;
+
+    return ret;
+}
+
+namespace
+{
+    FILE* open_stream(const std::string& file, const char* fmode)
+    {
+        #ifndef __EMSCRIPTEN__
+        FILE* f = fopen(file.c_str(), fmode);
+        #else
+        FILE* f = fopen(("web/" + file).c_str(), fmode);
+        #endif
+
+        ///reader and writer do their own buffering
+        if(f != nullptr)
+            setvbuf(f, nullptr, _IONBF, 0);
+
+        return f;
+    }
+
+    uint64_t stream_size(FILE* f)
+    {
+        #ifdef __WIN32__
+        _fseeki64(f, 0, SEEK_END);
+        int64_t fsize = _ftelli64(f);
+        _fseeki64(f, 0, SEEK_SET);
+        #else
+        fseeko(f, 0, SEEK_END);
+        int64_t fsize = ftello(f);
+        fseeko(f, 0, SEEK_SET);
+        #endif // __WIN32__
+
+        return fsize < 0 ? 0 : fsize;
+    }
+}
+
+file::reader::reader(const std::string& file, size_t buffer_size)
+{
+    if(std::optional<mapped_file> found = file::pack::map(file))
+    {
+        packed = std::move(found.value());
+        is_packed = true;
+        total = packed.size();
+    }
+    else if(find_unflushed(file) != nullptr)
+    {
+        packed = file::map(file);
+        is_packed = true;
+        total = packed.size();
+    }
+    else
+    {
+        f = open_stream(file, "rb");
+
+        if(f == nullptr)
+            return;
+
+        total = stream_size(f);
+
+        #if defined(__linux__) && !defined(__EMSCRIPTEN__)
+        posix_fadvise(fileno(f), 0, 0, POSIX_FADV_SEQUENTIAL);
+        #endif
+    }
+
+    buffer.resize(buffer_size > 0 ? buffer_size : 1);
+}
+
+file::reader::~reader()
+{
+    if(f)
+        fclose(f);
+}
+
+bool file::reader::is_open() const
+{
+    return f != nullptr || is_packed;
+}
+
+uint64_t file::reader::size() const
+{
+    return total;
+}
+
+uint64_t file::reader::position() const
+{
+    return offset;
+}
+
+std::string_view file::reader::next()
+{
+    if(is_packed)
+    {
+        size_t len = std::min((uint64_t)buffer.size(), total - offset);
+
+        std::string_view ret(packed.data() + offset, len);
+        offset += len;
+        return ret;
+    }
+
+    if(f == nullptr)
+        return std::string_view();
+
+    size_t len = fread(buffer.data(), 1, buffer.size(), f);
+    offset += len;
+
+    #if defined(__linux__) && !defined(__EMSCRIPTEN__)
+    ///starts the kernel reading the next chunk, while the caller is busy with this one
+    if(len > 0)
+        posix_fadvise(fileno(f), offset, buffer.size(), POSIX_FADV_WILLNEED);
+    #endif
+
+    return std::string_view(buffer.data(), len);
+}
+
+void file::reader::for_each(const std::function<void(std::string_view)>& on_chunk)
+{
+    while(1)
+    {
+        std::string_view chunk = next();
+
+        if(chunk.size() == 0)
+            return;
+
+        on_chunk(chunk);
+    }
+}
+
+file::writer::writer(const std::string& file, size_t buffer_size)
+{
+    forget_cached(file);
+    settle_unflushed(file);
+
+    f = open_stream(file, "wb");
+
+    buffer.resize(buffer_size > 0 ? buffer_size : 1);
+}
+
+file::writer::~writer()
+{
+    if(f == nullptr)
+        return;
+
+    flush();
+    fclose(f);
+
+    sync_writes();
+}
+
+bool file::writer::is_open() const
+{
+    return f != nullptr;
+}
+
+bool file::writer::good() const
+{
+    return f != nullptr && !failed;
+}
+
+void file::writer::write(std::string_view data)
+{
+    if(f == nullptr)
+        return;
+
+    if(data.size() > buffer.size() - used)
+        flush();
 
-    if(fsize == -1L)
+    if(data.size() >= buffer.size())
     {
-        fclose(f);
-        return "";
-    }
-
-    std::string buffer;
-    buffer.resize(fsize);
-    size_t real = fread(buffer.data(), 1, fsize, f);
-    buffer.resize(real);
+        if(fwrite(data.data(), 1, data.size(), f) != data.size())
+            failed = true;
 
-    fclose(f);
+        return;
+    }
 
-    return buffer;
+    memcpy(buffer.data() + used, data.data(), data.size());
+    used += data.size();
 }
 
-std::string file::read(const std::string& file, file::mode::type m)
+void file::writer::flush()
 {
-    #ifndef __EMSCRIPTEN__
-    return read_impl(file, m);
-    #else
-    return read_impl("web/" + file, m);
-    #endif
+    if(f == nullptr || used == 0)
+        return;
+
+    if(fwrite(buffer.data(), 1, used, f) != used)
+        failed = true;
+
+    used = 0;
 }
 
 std::optional<std::string> file::request::read(const std::string& file, file::mode::type m)
 {
+    if(std::optional<std::string> packed = file::pack::read(file))
+        return packed;
+
+    if(std::shared_ptr<const unflushed_write> pending = find_unflushed(file))
+        return pending->data;
+
     #ifndef __EMSCRIPTEN__
     if(!file::exists(file))
         return std::nullopt;
@@ -150,35 +1002,328 @@ std::optional<std::string> file::request::read(const std::string& file, file::mo
 
 void file::write(const std::string& file, const std::string& data, file::mode::type m)
 {
+    forget_cached(file);
+
+    if(syncs > 0)
     {
-        if(m == file::mode::BINARY)
+        unflushed[file] = std::make_shared<const unflushed_write>(unflushed_write{data, m});
+        return;
+    }
+
+    settle_unflushed(file);
+    write_impl(file, data, m);
+
+    sync_writes();
+}
+
+std::optional<std::string> file::pending::find(const std::string& file)
+{
+    if(std::shared_ptr<const unflushed_write> pending = find_unflushed(file))
+        return pending->data;
+
+    return std::nullopt;
+}
+
+void file::pending::supersede(const std::string& file)
+{
+    forget_cached(file);
+    unflushed.erase(file);
+}
+
+void file::pending::wait_for(const std::string& file)
+{
+    #ifndef __EMSCRIPTEN__
+    get_write_behind().wait_for(file);
+    #endif // __EMSCRIPTEN__
+}
+
+namespace
+{
+    ///a write_atomic whose temporary file is written, but not yet flushed or renamed into place
+    struct pending_atomic
+    {
+        std::string file;
+        std::string atomic_file;
+        std::string backup_file;
+        file::durability::type durability = file::durability::DATA;
+
+        #ifdef __WIN32__
+        HANDLE handle = INVALID_HANDLE_VALUE;
+        #else
+        int fd = -1;
+        #endif // __WIN32__
+    };
+
+    thread_local int group_commits = 0;
+    thread_local std::vector<pending_atomic> pending_atomics;
+
+    #ifndef __EMSCRIPTEN__
+    void close_pending(pending_atomic& p)
+    {
+        #ifdef __WIN32__
+        if(p.handle != INVALID_HANDLE_VALUE)
+            CloseHandle(p.handle);
+
+        p.handle = INVALID_HANDLE_VALUE;
+        #else
+        if(p.fd != -1)
+            close(p.fd);
+
+        p.fd = -1;
+        #endif // __WIN32__
+    }
+
+    #ifndef __WIN32__
+    bool write_all(int fd, const std::string& data)
+    {
+        size_t written = 0;
+
+        while(written < data.size())
         {
-            #ifndef __EMSCRIPTEN__
-            std::ofstream out(file, std::ios::binary);
-            #else
-            std::ofstream out("web/" + file, std::ios::binary);
-            #endif
-            out << data;
+            ssize_t rval = ::write(fd, data.data() + written, data.size() - written);
+
+            if(rval == -1)
+            {
+                if(errno == EINTR)
+                    continue;
+
+                return false;
+            }
+
+            written += rval;
         }
-        else if(m == file::mode::TEXT)
+
+        return true;
+    }
+
+    #endif // __WIN32__
+
+    ///writes the new contents next to the file, without flushing them. Returns false and leaves nothing behind on failure
+    bool write_temporary(pending_atomic& p, const std::string& data, file::mode::type m)
+    {
+        #ifdef __WIN32__
+        std::string converted;
+        const std::string* to_write = &data;
+
+        if(m == file::mode::TEXT)
         {
-            #ifndef __EMSCRIPTEN__
-            std::ofstream out(file);
+            converted.reserve(data.size());
+
+            for(char c : data)
+            {
+                if(c == '\n')
+                    converted.push_back('\r');
+
+                converted.push_back(c);
+            }
+
+            to_write = &converted;
+        }
+
+        p.handle = CreateFileA(p.atomic_file.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if(p.handle == INVALID_HANDLE_VALUE)
+            return false;
+
+        size_t written = 0;
+
+        while(written < to_write->size())
+        {
+            DWORD chunk = to_write->size() - written > (1 << 30) ? (1 << 30) : (DWORD)(to_write->size() - written);
+            DWORD did_write = 0;
+
+            if(!WriteFile(p.handle, to_write->data() + written, chunk, &did_write, nullptr))
+            {
+                close_pending(p);
+                DeleteFileA(p.atomic_file.c_str());
+                return false;
+            }
+
+            written += did_write;
+        }
+
+        return true;
+        #else
+        (void)m;
+
+        #ifdef O_TMPFILE
+        ///an unnamed file only gets linked in once it's complete, so a crash part way through writing leaves no partial .atom behind
+        int fd = open(directory_of(p.file).c_str(), O_TMPFILE | O_WRONLY | O_CLOEXEC, 0666);
+
+        if(fd != -1)
+        {
+            if(write_all(fd, data))
+            {
+                std::string proc_path = "/proc/self/fd/" + std::to_string(fd);
+
+                ::unlink(p.atomic_file.c_str());
+
+                if(linkat(AT_FDCWD, proc_path.c_str(), AT_FDCWD, p.atomic_file.c_str(), AT_SYMLINK_FOLLOW) == 0)
+                {
+                    p.fd = fd;
+                    return true;
+                }
+            }
+
+            ///eg no /proc, or a filesystem without O_TMPFILE support. Fall through to a named file
+            close(fd);
+        }
+        #endif // O_TMPFILE
+
+        p.fd = open(p.atomic_file.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0666);
+
+        if(p.fd == -1)
+            return false;
+
+        if(!write_all(p.fd, data))
+        {
+            close_pending(p);
+            ::unlink(p.atomic_file.c_str());
+            return false;
+        }
+
+        return true;
+        #endif // __WIN32__
+    }
+
+    ///flushes the temporary files' contents, each with its own flush, as syncfs would also wait on every other write to the filesystem
+    void flush_temporaries(std::vector<pending_atomic>& pending)
+    {
+        #ifdef __linux__
+        ///starts writeback of every file first, so that the disk works on all of them at once rather than one per fdatasync
+        for(pending_atomic& p : pending)
+        {
+            if(p.fd != -1 && p.durability != file::durability::NONE)
+                sync_file_range(p.fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+        }
+        #endif // __linux__
+
+        for(pending_atomic& p : pending)
+        {
+            if(p.durability == file::durability::NONE)
+                continue;
+
+            #ifdef __WIN32__
+            if(p.handle != INVALID_HANDLE_VALUE)
+                FlushFileBuffers(p.handle);
             #else
-            std::ofstream out("web/" + file);
-            #endif
-            out << data;
+            if(p.fd == -1)
+                continue;
+
+            #ifdef __APPLE__
+            ///fsync doesn't reach the disk on macos
+            fcntl(p.fd, F_FULLFSYNC);
+            #else
+            fdatasync(p.fd);
+            #endif // __APPLE__
+            #endif // __WIN32__
         }
     }
 
-    sync_writes();
+    ///swaps the temporary file into place, and moves the old contents to the backup
+    void rename_into_place(pending_atomic& p)
+    {
+        close_pending(p);
+        forget_cached(p.file);
+
+        #ifdef __WIN32__
+        if(GetFileAttributesA(p.file.c_str()) != INVALID_FILE_ATTRIBUTES)
+        {
+            DeleteFileA(p.backup_file.c_str());
+
+            if(ReplaceFileA(p.file.c_str(), p.atomic_file.c_str(), p.backup_file.c_str(), REPLACEFILE_IGNORE_MERGE_ERRORS, nullptr, nullptr))
+                return;
+        }
+
+        DWORD flags = MOVEFILE_REPLACE_EXISTING;
+
+        if(p.durability == file::durability::FULL)
+            flags |= MOVEFILE_WRITE_THROUGH;
+
+        MoveFileExA(p.atomic_file.c_str(), p.file.c_str(), flags);
+        #else
+        #if defined(__linux__) && defined(RENAME_EXCHANGE)
+        ///one step, and afterwards the .atom holds the old contents
+        if(renameat2(AT_FDCWD, p.atomic_file.c_str(), AT_FDCWD, p.file.c_str(), RENAME_EXCHANGE) == 0)
+        {
+            ::rename(p.atomic_file.c_str(), p.backup_file.c_str());
+            return;
+        }
+        #endif // RENAME_EXCHANGE
+
+        ///the file never goes missing, unlike renaming it out of the way first
+        ::unlink(p.backup_file.c_str());
+        ::link(p.file.c_str(), p.backup_file.c_str());
+        ::rename(p.atomic_file.c_str(), p.file.c_str());
+        #endif // __WIN32__
+    }
+
+    void commit_atomics(std::vector<pending_atomic>& pending)
+    {
+        flush_temporaries(pending);
+
+        for(pending_atomic& p : pending)
+        {
+            rename_into_place(p);
+        }
+
+        #ifndef __WIN32__
+        std::vector<std::string> directories;
+
+        for(pending_atomic& p : pending)
+        {
+            if(p.durability != file::durability::FULL)
+                continue;
+
+            std::string dir = directory_of(p.file);
+
+            if(std::find(directories.begin(), directories.end(), dir) == directories.end())
+                directories.push_back(dir);
+        }
+
+        for(const std::string& dir : directories)
+        {
+            int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+            if(fd == -1)
+                continue;
+
+            fsync(fd);
+            close(fd);
+        }
+        #endif // __WIN32__
+    }
+    #endif // __EMSCRIPTEN__
+}
+
+file::group_commit::group_commit()
+{
+    group_commits++;
+}
+
+file::group_commit::~group_commit()
+{
+    group_commits--;
+
+    #ifndef __EMSCRIPTEN__
+    if(group_commits == 0 && pending_atomics.size() > 0)
+    {
+        std::vector<pending_atomic> pending = std::move(pending_atomics);
+        pending_atomics.clear();
+
+        commit_atomics(pending);
+    }
+    #endif // __EMSCRIPTEN__
 }
 
-void file::write_atomic(const std::string& in_file, const std::string& data, file::mode::type m)
+void file::write_atomic(const std::string& in_file, const std::string& data, file::mode::type m, file::durability::type d)
 {
     if(data.size() == 0)
         return;
 
+    forget_cached(in_file);
+    settle_unflushed(in_file);
+
     #ifndef __EMSCRIPTEN__
     std::string file = in_file;
     #else
@@ -189,34 +1334,40 @@ void file::write_atomic(const std::string& in_file, const std::string& data, fil
     std::string atomic_file = file + atomic_extension;
     std::string backup_file = file + ".back";
 
-    /*#ifdef __WIN32__
-    HANDLE handle = CreateFile(atomic_file.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
-    WriteFile(handle, &data[0], data.size(), nullptr, nullptr);
-    //FlushFileBuffers(handle);
-    CloseHandle(handle);
-    #else
-    int fd = open(atomic_file.c_str(), O_CREAT | O_DIRECT | O_SYNC | O_TRUNC | O_WRONLY, 0777);
-
-    int written = 0;
-
-    while(written < data.size())
+    #ifndef __EMSCRIPTEN__
+    ///an earlier write to the same file in this group shares its .atom, and is superseded anyway
+    for(int i=0; i < (int)pending_atomics.size(); i++)
     {
-        int rval = ::write(fd, &data[written], (int)data.size() - written);
-
-        if(rval == -1)
+        if(pending_atomics[i].file == file)
         {
-            close(fd);
-            throw std::runtime_error("Errno in atomic write " + std::to_string(errno));
+            close_pending(pending_atomics[i]);
+            pending_atomics.erase(pending_atomics.begin() + i);
+            i--;
         }
-
-        written += rval;
     }
 
-    close(fd);
+    pending_atomic p;
+    p.file = file;
+    p.atomic_file = atomic_file;
+    p.backup_file = backup_file;
+    p.durability = d;
+
+    if(!write_temporary(p, data, m))
+        return;
+
+    if(group_commits > 0)
+    {
+        pending_atomics.push_back(std::move(p));
+        return;
+    }
 
-    return;
+    std::vector<pending_atomic> pending;
+    pending.push_back(std::move(p));
 
-    #endif // __WIN32__*/
+    commit_atomics(pending);
+    #else
+    ///there's nothing to fsync in memfs, the equivalent is sync_writes
+    (void)d;
 
     if(m == file::mode::TEXT)
     {
@@ -233,81 +1384,142 @@ void file::write_atomic(const std::string& in_file, const std::string& data, fil
 
     sync_writes();
 
-    if(!file::exists(file))
+    if(!file::exists(in_file))
     {
         ::rename(atomic_file.c_str(), file.c_str());
         sync_writes();
         return;
     }
 
-    if(file::exists(backup_file))
+    if(file::exists(in_file + ".back"))
     {
         ::remove(backup_file.c_str());
     }
 
-    /*steady_timer timer;
+    ::rename(file.c_str(), backup_file.c_str());
+    ::rename(atomic_file.c_str(), file.c_str());
+    #endif // __EMSCRIPTEN__
+}
+
+file::directory_cache::directory_cache()
+{
+    directory_caches++;
+}
+
+file::directory_cache::~directory_cache()
+{
+    directory_caches--;
+
+    if(directory_caches == 0)
+        cached_directories.clear();
+}
 
-    bool write_success = false;
-    bool any_errors = false;
+file::metadata file::stat(const std::string& name)
+{
+    metadata ret;
 
-    do
+    if(std::optional<uint64_t> packed = file::pack::size(name))
     {
-        #ifdef __WIN32__
-        //bool err = ReplaceFileA(file.c_str(), atomic_file.c_str(), backup_file.c_str(), REPLACEFILE_IGNORE_MERGE_ERRORS, nullptr, nullptr) == 0;
-        bool err = ReplaceFileA(file.c_str(), atomic_file.c_str(), nullptr, REPLACEFILE_IGNORE_MERGE_ERRORS, nullptr, nullptr) == 0;
-        #else
-        bool err = ::rename(atomic_file.c_str(), file.c_str()) != 0;
-        #endif // __WIN32__
+        ret.exists = true;
+        ret.size = packed.value();
+        return ret;
+    }
 
-        //bool err = ReplaceFileA(file.c_str(), atomic_file.c_str(), nullptr, REPLACEFILE_IGNORE_MERGE_ERRORS, nullptr, nullptr) == 0;
+    if(std::shared_ptr<const unflushed_write> pending = find_unflushed(name))
+    {
+        ret.exists = true;
+        ret.size = pending->data.size();
+        return ret;
+    }
 
-        if(!err)
-        {
-            write_success = true;
-            break;
-        }
+    #ifndef __EMSCRIPTEN__
+    std::string file = name;
+    #else
+    std::string file = "web/" + name;
+    #endif
 
-        if(err)
-        {
-            #ifdef __WIN32__
-            printf("atomic write error %lu ", GetLastError());
-            #else
-            printf("atomic write error %i %s\n", errno, file.c_str());
-            #endif // __WIN32__
+    #if defined(__WIN32__)
+    WIN32_FILE_ATTRIBUTE_DATA attributes = {};
 
-            any_errors = true;
-        }
+    if(!GetFileAttributesExA(file.c_str(), GetFileExInfoStandard, &attributes))
+        return ret;
 
-        sync_writes();
-    }
-    while(timer.get_elapsed_time_s() < 1);*/
+    ret.exists = true;
+    ret.is_dir = (attributes.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    ret.size = ((uint64_t)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
 
-    ::rename(file.c_str(), backup_file.c_str());
-    ::rename(atomic_file.c_str(), file.c_str());
+    ///filetimes are in 100ns intervals since 1601
+    uint64_t filetime = ((uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+    uint64_t epoch_difference = 116444736000000000ull;
 
-    /*if(!write_success)
-    {
-        throw std::runtime_error("Explod in atomic write");
-    }*/
+    ret.mtime_ns = filetime > epoch_difference ? (filetime - epoch_difference) * 100 : 0;
+    #elif defined(__linux__) && !defined(__EMSCRIPTEN__) && defined(STATX_SIZE)
+    ///only asks for the fields that are used, which saves work on network filesystems
+    struct statx stx = {};
 
-    /*if(any_errors)
-    {
-        printf("atomic_write had errors but recovered");
-    }*/
+    if(statx(AT_FDCWD, file.c_str(), AT_STATX_SYNC_AS_STAT, STATX_TYPE | STATX_SIZE | STATX_MTIME, &stx) != 0)
+        return ret;
+
+    ret.exists = true;
+    ret.is_dir = S_ISDIR(stx.stx_mode);
+    ret.size = stx.stx_size;
+    ret.mtime_ns = (uint64_t)stx.stx_mtime.tv_sec * 1000000000ull + stx.stx_mtime.tv_nsec;
+    #else
+    struct stat st = {};
+
+    if(::stat(file.c_str(), &st) != 0)
+        return ret;
+
+    ret.exists = true;
+    ret.is_dir = S_ISDIR(st.st_mode);
+    ret.size = st.st_size;
+
+    #if defined(__APPLE__)
+    ret.mtime_ns = (uint64_t)st.st_mtimespec.tv_sec * 1000000000ull + st.st_mtimespec.tv_nsec;
+    #else
+    ret.mtime_ns = (uint64_t)st.st_mtim.tv_sec * 1000000000ull + st.st_mtim.tv_nsec;
+    #endif // __APPLE__
+    #endif
+
+    return ret;
 }
 
 bool file::exists(const std::string& name)
 {
-    #ifndef __EMSCRIPTEN__
-    std::ifstream f(name.c_str());
-    #else
-    std::ifstream f(("web/" + name).c_str());
-    #endif
-    return f.good();
+    if(file::pack::exists(name) || find_unflushed(name) != nullptr)
+        return true;
+
+    if(directory_caches > 0)
+        return find_cached(name).has_value();
+
+    return file::stat(name).exists;
+}
+
+bool file::is_dir(const std::string& name)
+{
+    if(directory_caches > 0)
+        return find_cached(name).value_or(false);
+
+    return file::stat(name).is_dir;
+}
+
+uint64_t file::size(const std::string& name)
+{
+    return file::stat(name).size;
+}
+
+uint64_t file::mtime_ns(const std::string& name)
+{
+    return file::stat(name).mtime_ns;
 }
 
 void file::rename(const std::string& from, const std::string& to)
 {
+    forget_cached(from);
+    forget_cached(to);
+    settle_unflushed(from);
+    settle_unflushed(to);
+
     #ifndef __EMSCRIPTEN__
     ::rename(from.c_str(), to.c_str());
     #else
@@ -319,6 +1531,9 @@ void file::rename(const std::string& from, const std::string& to)
 
 bool file::remove(const std::string& name)
 {
+    forget_cached(name);
+    settle_unflushed(name);
+
     #ifndef __EMSCRIPTEN__
     return ::remove(name.c_str()) == 0;
     #else
@@ -328,6 +1543,8 @@ bool file::remove(const std::string& name)
 
 void file::mkdir(const std::string& name)
 {
+    forget_cached(name);
+
     #ifndef __EMSCRIPTEN__
     #ifdef __WIN32__
     ::_mkdir(name.c_str());
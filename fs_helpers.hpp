@@ -3,6 +3,13 @@
 
 #include <string>
 #include <optional>
+#include <string_view>
+#include <cstddef>
+#include <memory>
+#include <functional>
+#include <future>
+#include <stdint.h>
+#include <stdio.h>
 
 ///a directory should be without prefixes, eg a/hello.txt
 namespace file
@@ -16,17 +23,178 @@ namespace file
         };
     }
 
-    ///for emscripten performance reasons
+    namespace durability
+    {
+        enum type
+        {
+            ///atomic, but a power loss can roll the file back to its previous contents
+            NONE,
+            ///the new contents are flushed before they replace the old ones, so a power loss leaves one or the other
+            DATA,
+            ///the rename is flushed as well, so the new contents survive a power loss once write_atomic returns
+            FULL
+        };
+    }
+
+    namespace access
+    {
+        enum type
+        {
+            SEQUENTIAL,
+            RANDOM,
+            NORMAL
+        };
+    }
+
+    ///a read only view of a whole file, which unmaps on destruction
+    ///backed by mmap where available, otherwise the file is read into memory and the view points at that
+    struct mapped_file
+    {
+        mapped_file();
+        ~mapped_file();
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        mapped_file(mapped_file&& other);
+        mapped_file& operator=(mapped_file&& other);
+
+        ///false if the file couldn't be opened. An empty file is valid
+        bool is_valid() const;
+        ///false if this fell back to a copy
+        bool is_mapped() const;
+
+        const char* data() const;
+        size_t size() const;
+
+        std::string_view view() const;
+        ///the same as data, for code that wants bytes rather than chars. size() bytes long
+        const std::byte* bytes() const;
+
+    private:
+        friend mapped_file map(const std::string& file, access::type hint);
+        friend struct mounted_pack;
+
+        const char* ptr = nullptr;
+        size_t len = 0;
+        bool valid = false;
+        bool mapped = false;
+        std::string fallback;
+
+        #ifdef __WIN32__
+        void* mapping_handle = nullptr;
+        #endif // __WIN32__
+
+        ///whatever a view points into, eg a mounted pack's own mapping, or a write which hasn't landed yet
+        std::shared_ptr<const void> owner;
+
+        void release();
+    };
+
+    ///file::writes on this thread are held back until the outermost manual_fs_sync ends, and only the last write to each path is kept
+    ///they're then written out together on a background thread, followed by a single syncfs on emscripten, which has no threads and writes them immediately
+    ///reads through file:: see the held back contents until they've landed
     struct manual_fs_sync
     {
         manual_fs_sync();
         ~manual_fs_sync();
+
+        ///ready once the writes held back by the outermost manual_fs_sync have been written out
+        std::shared_future<void> completion();
+    };
+
+    ///while one is alive, exists and is_dir on this thread list each directory once and answer from that, rather than asking the os every time
+    ///changes made through file:: on this thread are picked up, but changes from other threads and processes aren't. Keep it short lived
+    struct directory_cache
+    {
+        directory_cache();
+        ~directory_cache();
+    };
+
+    struct metadata
+    {
+        bool exists = false;
+        bool is_dir = false;
+        uint64_t size = 0;
+        ///nanoseconds since the unix epoch
+        uint64_t mtime_ns = 0;
+    };
+
+    ///write_atomics on this thread are held back until the outermost group_commit ends, and then flushed and renamed together
+    ///until then the files keep their old contents. Writing the same file twice only commits the last write
+    struct group_commit
+    {
+        group_commit();
+        ~group_commit();
+    };
+
+    ///reads a file a chunk at a time through one fixed buffer, so a file of any size takes the same memory
+    ///on linux the next chunk is requested from the kernel while the current one is processed. Always binary
+    struct reader
+    {
+        reader(const std::string& file, size_t buffer_size = 1024 * 1024);
+        ~reader();
+
+        reader(const reader&) = delete;
+        reader& operator=(const reader&) = delete;
+
+        bool is_open() const;
+        ///of the whole file, or 0 if it couldn't be opened
+        uint64_t size() const;
+        uint64_t position() const;
+
+        ///the next chunk, which is valid until the next call. Empty once the file is finished
+        std::string_view next();
+        ///calls on_chunk with every remaining chunk in order
+        void for_each(const std::function<void(std::string_view)>& on_chunk);
+
+    private:
+        FILE* f = nullptr;
+        ///files inside a mounted pack are handed out as views of it, without a copy
+        mapped_file packed;
+        bool is_packed = false;
+
+        std::string buffer;
+        uint64_t total = 0;
+        uint64_t offset = 0;
+    };
+
+    ///buffers writes into a fixed buffer, and writes anything larger than the buffer straight through. Always binary
+    struct writer
+    {
+        writer(const std::string& file, size_t buffer_size = 1024 * 1024);
+        ///flushes
+        ~writer();
+
+        writer(const writer&) = delete;
+        writer& operator=(const writer&) = delete;
+
+        bool is_open() const;
+        ///false if any write has failed, eg the disk filled up
+        bool good() const;
+
+        void write(std::string_view data);
+        void flush();
+
+    private:
+        FILE* f = nullptr;
+        std::string buffer;
+        size_t used = 0;
+        bool failed = false;
     };
 
     std::string read(const std::string& file, mode::type m);
+    ///always binary. The hint is passed on to madvise
+    mapped_file map(const std::string& file, access::type hint = access::SEQUENTIAL);
     void write(const std::string& file, const std::string& data, mode::type m);
-    void write_atomic(const std::string& file, const std::string& data, mode::type m);
+    ///replaces the file in one step, keeping the previous version as file.back
+    void write_atomic(const std::string& file, const std::string& data, mode::type m, durability::type d = durability::DATA);
+    ///a single stat, or statx on linux. Files in a mounted pack report their uncompressed size, and no mtime
+    metadata stat(const std::string& name);
     bool exists(const std::string& name);
+    bool is_dir(const std::string& name);
+    uint64_t size(const std::string& name);
+    uint64_t mtime_ns(const std::string& name);
     void rename(const std::string& from, const std::string& to);
     bool remove(const std::string& name);
 
@@ -37,6 +205,17 @@ namespace file
         std::optional<std::string> read(const std::string& file, mode::type m);
     }
 
+    ///for code which goes to the os without going through file::, eg fs_async
+    namespace pending
+    {
+        ///the contents of a write which hasn't landed yet, either held back by this thread's manual_fs_sync or still being written out
+        std::optional<std::string> find(const std::string& file);
+        ///a newer write to the file is about to go straight to the os, so this thread's held back write to it is dropped, rather than landing on top later
+        void supersede(const std::string& file);
+        ///waits for a background write of the file to land. Any thread
+        void wait_for(const std::string& file);
+    }
+
     #ifdef __EMSCRIPTEN__
     // EMSCRIPTEN ONLY OBVIOUSLY
     void download(const std::string& name, const std::string& data);
@@ -0,0 +1,466 @@
+#include "fs_pack.hpp"
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif // USE_LZ4
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif // USE_ZSTD
+
+///a pack is a header, the file contents, an index sorted by the hash of each name, and then the names
+///everything is little endian, and the index is 8 byte aligned
+namespace
+{
+    constexpr char pack_magic[8] = {'J', 'G', 'T', 'P', 'A', 'C', 'K', '1'};
+    constexpr uint32_t pack_version = 2;
+
+    struct pack_header
+    {
+        char magic[8] = {};
+        uint32_t version = 0;
+        uint32_t count = 0;
+        uint64_t index_offset = 0;
+        uint64_t names_offset = 0;
+    };
+
+    struct pack_entry
+    {
+        uint64_t name_hash = 0;
+        uint64_t offset = 0;
+        uint64_t stored_size = 0;
+        uint64_t size = 0;
+        uint32_t name_offset = 0;
+        uint32_t name_length = 0;
+        uint32_t compression = 0;
+        uint32_t reserved = 0;
+        ///of the stored bytes, so that corruption is caught before anything is decompressed
+        uint64_t content_hash = 0;
+    };
+
+    static_assert(sizeof(pack_header) == 32);
+    static_assert(sizeof(pack_entry) == 56);
+
+    ///fnv-1a
+    uint64_t hash_name(std::string_view name)
+    {
+        uint64_t hash = 14695981039346656037ull;
+
+        for(char c : name)
+        {
+            hash ^= (uint8_t)c;
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    uint64_t hash_content(std::string_view data)
+    {
+        return hash_name(data);
+    }
+
+    ///lz4 can't do better than this, as every 255 bytes of a match costs at least one byte
+    constexpr uint64_t lz4_max_ratio = 255;
+    ///entries are handed out as one string, and the lz4 api takes ints
+    constexpr uint64_t max_entry_size = INT_MAX;
+
+    std::optional<std::string> compress(const std::string& data, file::compression::type c)
+    {
+        std::string out;
+
+        #ifdef USE_LZ4
+        if(c == file::compression::LZ4)
+        {
+            out.resize(LZ4_compressBound((int)data.size()));
+
+            int written = LZ4_compress_default(data.data(), out.data(), (int)data.size(), (int)out.size());
+
+            if(written <= 0)
+                return std::nullopt;
+
+            out.resize(written);
+            return out;
+        }
+        #endif // USE_LZ4
+
+        #ifdef USE_ZSTD
+        if(c == file::compression::ZSTD)
+        {
+            out.resize(ZSTD_compressBound(data.size()));
+
+            size_t written = ZSTD_compress(out.data(), out.size(), data.data(), data.size(), 19);
+
+            if(ZSTD_isError(written))
+                return std::nullopt;
+
+            out.resize(written);
+            return out;
+        }
+        #endif // USE_ZSTD
+
+        (void)data;
+        (void)c;
+        return std::nullopt;
+    }
+
+    ///the sizes come from the pack, so they're checked before anything gets allocated for them
+    std::optional<std::string> decompress(const char* data, const pack_entry& entry)
+    {
+        if(entry.size > max_entry_size || entry.stored_size > max_entry_size)
+            return std::nullopt;
+
+        #ifdef USE_LZ4
+        if(entry.compression == file::compression::LZ4)
+        {
+            if(entry.size > entry.stored_size * lz4_max_ratio)
+                return std::nullopt;
+
+            std::string out;
+            out.resize(entry.size);
+
+            int read = LZ4_decompress_safe(data, out.data(), (int)entry.stored_size, (int)entry.size);
+
+            if(read < 0 || (uint64_t)read != entry.size)
+                return std::nullopt;
+
+            return out;
+        }
+        #endif // USE_LZ4
+
+        #ifdef USE_ZSTD
+        if(entry.compression == file::compression::ZSTD)
+        {
+            ///zstd has no useful ratio limit, but the frame records its own size
+            unsigned long long frame_size = ZSTD_getFrameContentSize(data, entry.stored_size);
+
+            if(frame_size != entry.size)
+                return std::nullopt;
+
+            std::string out;
+            out.resize(entry.size);
+
+            size_t read = ZSTD_decompress(out.data(), out.size(), data, entry.stored_size);
+
+            if(ZSTD_isError(read) || read != entry.size)
+                return std::nullopt;
+
+            return out;
+        }
+        #endif // USE_ZSTD
+
+        ///compressed with something that isn't compiled in
+        (void)data;
+        return std::nullopt;
+    }
+}
+
+namespace file
+{
+    struct mounted_pack
+    {
+        std::string pack_file;
+        std::string prefix;
+
+        std::shared_ptr<mapped_file> mapping;
+        std::vector<pack_entry> entries;
+        const char* names = nullptr;
+        size_t names_size = 0;
+
+        ///each entry's hash is checked the first time it's used, rather than hashing the whole pack on mount
+        std::unique_ptr<std::atomic_bool[]> verified;
+
+        bool load()
+        {
+            mapping = std::make_shared<mapped_file>(file::map(pack_file, file::access::RANDOM));
+
+            const char* base = mapping->data();
+            size_t size = mapping->size();
+
+            pack_header header;
+
+            if(!mapping->is_valid() || size < sizeof(header))
+                return false;
+
+            memcpy(&header, base, sizeof(header));
+
+            if(memcmp(header.magic, pack_magic, sizeof(pack_magic)) != 0 || header.version != pack_version)
+                return false;
+
+            if(header.index_offset > size || header.count > (size - header.index_offset) / sizeof(pack_entry) || header.names_offset > size)
+                return false;
+
+            entries.resize(header.count);
+
+            if(header.count > 0)
+                memcpy(entries.data(), base + header.index_offset, header.count * sizeof(pack_entry));
+
+            names = base + header.names_offset;
+            names_size = size - header.names_offset;
+
+            for(const pack_entry& e : entries)
+            {
+                if(e.offset > size || e.stored_size > size - e.offset || (uint64_t)e.name_offset + e.name_length > names_size)
+                    return false;
+
+                if(e.compression == compression::NONE && e.size != e.stored_size)
+                    return false;
+            }
+
+            verified = std::make_unique<std::atomic_bool[]>(entries.size());
+
+            return true;
+        }
+
+        ///two threads may both check an entry the first time, which is harmless
+        bool verify(const pack_entry& e) const
+        {
+            std::atomic_bool& done = verified[&e - entries.data()];
+
+            if(done.load(std::memory_order_acquire))
+                return true;
+
+            if(hash_content(std::string_view(mapping->data() + e.offset, e.stored_size)) != e.content_hash)
+                return false;
+
+            done.store(true, std::memory_order_release);
+            return true;
+        }
+
+        std::string_view name_of(const pack_entry& e) const
+        {
+            return std::string_view(names + e.name_offset, e.name_length);
+        }
+
+        const pack_entry* find(std::string_view file) const
+        {
+            if(file.substr(0, prefix.size()) != prefix)
+                return nullptr;
+
+            std::string_view name = file.substr(prefix.size());
+
+            uint64_t hash = hash_name(name);
+
+            auto it = std::lower_bound(entries.begin(), entries.end(), hash, [](const pack_entry& e, uint64_t h){return e.name_hash < h;});
+
+            for(; it != entries.end() && it->name_hash == hash; it++)
+            {
+                if(name_of(*it) == name)
+                    return &*it;
+            }
+
+            return nullptr;
+        }
+
+        std::optional<std::string> read(const pack_entry& e) const
+        {
+            if(!verify(e))
+                return std::nullopt;
+
+            const char* data = mapping->data() + e.offset;
+
+            if(e.compression == compression::NONE)
+                return std::string(data, e.stored_size);
+
+            return decompress(data, e);
+        }
+
+        std::optional<mapped_file> map(const pack_entry& e) const
+        {
+            mapped_file ret;
+            ret.valid = true;
+
+            if(e.compression == compression::NONE)
+            {
+                if(!verify(e))
+                    return std::nullopt;
+
+                ret.ptr = mapping->data() + e.offset;
+                ret.len = e.stored_size;
+                ///not a copy, even if the pack itself had to be read into memory
+                ret.mapped = true;
+                ret.owner = mapping;
+                return std::optional<mapped_file>(std::move(ret));
+            }
+
+            std::optional<std::string> data = read(e);
+
+            if(!data.has_value())
+                return std::nullopt;
+
+            ret.fallback = std::move(data.value());
+            ret.ptr = ret.fallback.data();
+            ret.len = ret.fallback.size();
+            return std::optional<mapped_file>(std::move(ret));
+        }
+    };
+}
+
+namespace
+{
+    std::shared_mutex mounts_lock;
+    ///most recently mounted last
+    std::vector<std::shared_ptr<file::mounted_pack>> mounts;
+    ///lets lookups skip the lock entirely when nothing is mounted
+    std::atomic_int mount_count{0};
+
+    template<typename T>
+    auto find_in_packs(const std::string& file, T&& func) -> decltype(func(std::declval<const file::mounted_pack&>(), std::declval<const pack_entry&>()))
+    {
+        if(mount_count.load(std::memory_order_acquire) == 0)
+            return {};
+
+        std::shared_lock guard(mounts_lock);
+
+        for(int i=(int)mounts.size() - 1; i >= 0; i--)
+        {
+            const pack_entry* e = mounts[i]->find(file);
+
+            if(e)
+                return func(*mounts[i], *e);
+        }
+
+        return {};
+    }
+}
+
+void file::build_pack(const std::string& pack_file, const std::vector<pack_source>& sources, compression::type c)
+{
+    #ifndef __EMSCRIPTEN__
+    std::ofstream out(pack_file, std::ios::binary);
+    #else
+    std::ofstream out("web/" + pack_file, std::ios::binary);
+    #endif
+
+    pack_header header;
+    memcpy(header.magic, pack_magic, sizeof(pack_magic));
+    header.version = pack_version;
+    header.count = sources.size();
+
+    out.write((const char*)&header, sizeof(header));
+
+    std::vector<pack_entry> entries;
+    std::string names;
+    uint64_t offset = sizeof(header);
+
+    for(const pack_source& source : sources)
+    {
+        pack_entry e;
+        e.name_hash = hash_name(source.name);
+        e.offset = offset;
+        e.size = source.data.size();
+        e.name_offset = names.size();
+        e.name_length = source.name.size();
+
+        std::optional<std::string> compressed;
+
+        ///anything larger couldn't be decompressed again
+        if(c != compression::NONE && source.data.size() <= max_entry_size)
+            compressed = compress(source.data, c);
+
+        if(compressed.has_value() && compressed->size() < source.data.size())
+        {
+            e.compression = c;
+            e.stored_size = compressed->size();
+            e.content_hash = hash_content(compressed.value());
+            out.write(compressed->data(), compressed->size());
+        }
+        else
+        {
+            e.compression = compression::NONE;
+            e.stored_size = source.data.size();
+            e.content_hash = hash_content(source.data);
+            out.write(source.data.data(), source.data.size());
+        }
+
+        offset += e.stored_size;
+        names += source.name;
+        entries.push_back(e);
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const pack_entry& e1, const pack_entry& e2){return e1.name_hash < e2.name_hash;});
+
+    uint64_t padding = (8 - offset % 8) % 8;
+    char zeroes[8] = {};
+    out.write(zeroes, padding);
+    offset += padding;
+
+    header.index_offset = offset;
+    header.names_offset = offset + entries.size() * sizeof(pack_entry);
+
+    if(entries.size() > 0)
+        out.write((const char*)entries.data(), entries.size() * sizeof(pack_entry));
+
+    out.write(names.data(), names.size());
+
+    out.seekp(0);
+    out.write((const char*)&header, sizeof(header));
+}
+
+bool file::mount(const std::string& pack_file, const std::string& prefix)
+{
+    auto pack = std::make_shared<mounted_pack>();
+    pack->pack_file = pack_file;
+    pack->prefix = prefix;
+
+    if(!pack->load())
+        return false;
+
+    std::unique_lock guard(mounts_lock);
+
+    mounts.push_back(std::move(pack));
+    mount_count = mounts.size();
+
+    return true;
+}
+
+void file::unmount(const std::string& pack_file)
+{
+    std::unique_lock guard(mounts_lock);
+
+    ///files already mapped out of the pack keep its mapping alive
+    mounts.erase(std::remove_if(mounts.begin(), mounts.end(), [&](const std::shared_ptr<mounted_pack>& pack){return pack->pack_file == pack_file;}), mounts.end());
+    mount_count = mounts.size();
+}
+
+std::optional<std::string> file::pack::read(const std::string& file)
+{
+    return find_in_packs(file, [](const mounted_pack& pack, const pack_entry& e)
+    {
+        return pack.read(e);
+    });
+}
+
+bool file::pack::exists(const std::string& file)
+{
+    return find_in_packs(file, [](const mounted_pack&, const pack_entry&)
+    {
+        return true;
+    });
+}
+
+std::optional<uint64_t> file::pack::size(const std::string& file)
+{
+    return find_in_packs(file, [](const mounted_pack&, const pack_entry& e)
+    {
+        return std::optional<uint64_t>(e.size);
+    });
+}
+
+std::optional<file::mapped_file> file::pack::map(const std::string& file)
+{
+    return find_in_packs(file, [](const mounted_pack& pack, const pack_entry& e)
+    {
+        return pack.map(e);
+    });
+}
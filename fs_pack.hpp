@@ -0,0 +1,53 @@
+#ifndef FS_PACK_HPP_INCLUDED
+#define FS_PACK_HPP_INCLUDED
+
+#include "fs_helpers.hpp"
+#include <string>
+#include <vector>
+#include <optional>
+#include <stdint.h>
+
+///packs bundle many files into one, so that loading assets is a single open and mmap rather than an open and stat per file
+///once mounted, file::read, file::exists, file::map and file::request::read look in packs before the os filesystem
+///packs are read only. A file written to disk with the same path as one in a mounted pack is shadowed by the pack
+namespace file
+{
+    namespace compression
+    {
+        enum type
+        {
+            NONE,
+            ///needs USE_LZ4
+            LZ4,
+            ///needs USE_ZSTD
+            ZSTD
+        };
+    }
+
+    struct pack_source
+    {
+        ///the path it will be looked up by, eg a/hello.txt
+        std::string name;
+        std::string data;
+    };
+
+    ///entries which don't get smaller are stored uncompressed, and can be mapped without a copy
+    void build_pack(const std::string& pack_file, const std::vector<pack_source>& sources, compression::type c = compression::NONE);
+
+    ///files in the pack are found under prefix + their name. Packs mounted later are searched first. Returns false if the pack is missing or corrupt
+    ///each file is checked against its hash the first time it's used, and one that doesn't match is treated as not being in the pack
+    bool mount(const std::string& pack_file, const std::string& prefix = "");
+    void unmount(const std::string& pack_file);
+
+    namespace pack
+    {
+        ///fs_helpers' hooks. These only search the mounted packs
+        std::optional<std::string> read(const std::string& file);
+        bool exists(const std::string& file);
+        ///uncompressed
+        std::optional<uint64_t> size(const std::string& file);
+        std::optional<mapped_file> map(const std::string& file);
+    }
+}
+
+#endif // FS_PACK_HPP_INCLUDED
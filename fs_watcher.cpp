@@ -0,0 +1,793 @@
+#include "fs_watcher.hpp"
+#include "fs_helpers.hpp"
+#include "clock.hpp"
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
+#include <algorithm>
+#include <stdint.h>
+#include <errno.h>
+#include <cmath>
+#include <optional>
+
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+#define USE_INOTIFY
+#endif
+
+#ifdef USE_INOTIFY
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <limits.h>
+#endif // USE_INOTIFY
+
+#include <tinydir/tinydir.h>
+
+namespace
+{
+    struct watched_directory
+    {
+        std::string path;
+        bool recursive = false;
+    };
+
+    struct waiting_roots
+    {
+        ///the nearest parent of the roots which exists
+        std::string parent;
+        std::vector<watched_directory> roots;
+    };
+
+    struct scanned_file
+    {
+        uint64_t size = 0;
+        uint64_t mtime_ns = 0;
+        bool is_dir = false;
+    };
+
+    std::string strip_trailing_slash(std::string dir)
+    {
+        while(dir.size() > 1 && (dir.back() == '/' || dir.back() == '\\'))
+            dir.pop_back();
+
+        return dir;
+    }
+
+    bool is_inside(const std::string& file, const std::string& dir)
+    {
+        return file.size() > dir.size() && file.compare(0, dir.size(), dir) == 0 && (file[dir.size()] == '/' || file[dir.size()] == '\\');
+    }
+
+    std::string parent_of(const std::string& dir)
+    {
+        size_t pos = dir.find_last_of("/\\");
+
+        if(pos == std::string::npos)
+            return ".";
+
+        if(pos == 0)
+            return "/";
+
+        return dir.substr(0, pos);
+    }
+
+    template<typename T>
+    void for_each_in_directory(const std::string& dir, T&& func)
+    {
+        tinydir_dir listing;
+
+        if(tinydir_open(&listing, dir.c_str()) == -1)
+            return;
+
+        while(listing.has_next)
+        {
+            tinydir_file f;
+
+            if(tinydir_readfile(&listing, &f) != -1)
+            {
+                std::string name = f.name;
+
+                if(name != "." && name != "..")
+                    func(dir + "/" + name, f);
+            }
+
+            tinydir_next(&listing);
+        }
+
+        tinydir_close(&listing);
+    }
+
+    ///tinydir_readfile has already statted the file everywhere but windows, so that's reused rather than statting it again
+    scanned_file to_scanned(const std::string& file, const tinydir_file& f)
+    {
+        #ifndef _WIN32
+        #ifdef __APPLE__
+        const timespec& mtime = f._s.st_mtimespec;
+        #else
+        const timespec& mtime = f._s.st_mtim;
+        #endif // __APPLE__
+
+        (void)file;
+
+        return {(uint64_t)f._s.st_size, (uint64_t)mtime.tv_sec * 1000000000ull + mtime.tv_nsec, (bool)f.is_dir};
+        #else
+        file::metadata meta = file::stat(file);
+
+        return {meta.size, meta.mtime_ns, (bool)f.is_dir};
+        #endif // _WIN32
+    }
+
+    ///touches only the filesystem, so call it without the watcher's lock held
+    void scan(const watched_directory& dir, std::unordered_map<std::string, scanned_file>& out)
+    {
+        for_each_in_directory(dir.path, [&](const std::string& file, const tinydir_file& f)
+        {
+            out[file] = to_scanned(file, f);
+
+            if(f.is_dir && dir.recursive)
+                scan({file, true}, out);
+        });
+    }
+}
+
+namespace file
+{
+    struct watcher_state
+    {
+        std::mutex lock;
+        std::condition_variable cv;
+        std::thread thread;
+        bool quit = false;
+
+        double debounce_s = 0;
+        double poll_interval_s = 0;
+
+        std::vector<watched_directory> roots;
+
+        ///file -> its coalesced change, since the last delivery
+        std::unordered_map<std::string, change::type> pending;
+        steady_timer since_last_change;
+
+        std::function<void(const std::vector<change_event>&)> callback;
+        std::vector<change_event> ready;
+
+        std::atomic_bool native{false};
+
+        ///only used while rescanning
+        std::unordered_map<std::string, scanned_file> snapshot;
+        steady_timer since_last_scan;
+        ///roots whose contents aren't in the snapshot yet. The next scan takes them as they are, rather than reporting everything in them as created
+        std::vector<std::string> unbaselined;
+
+        #ifdef USE_INOTIFY
+        int inotify_fd = -1;
+        int wake_fd = -1;
+        ///watch descriptor -> the directory it watches
+        std::unordered_map<int, watched_directory> watches;
+        ///watch descriptor -> roots which don't exist yet, waiting on their nearest parent which does
+        std::unordered_map<int, waiting_roots> waiting;
+        #endif // USE_INOTIFY
+
+        void note(const std::string& file, change::type type)
+        {
+            since_last_change.restart();
+
+            auto it = pending.find(file);
+
+            if(it == pending.end())
+            {
+                pending[file] = type;
+                return;
+            }
+
+            change::type& last = it->second;
+
+            ///never seen by anyone, so nothing to report
+            if(last == change::CREATED && type == change::REMOVED)
+            {
+                pending.erase(it);
+                return;
+            }
+
+            ///still new, however many times it's written to
+            if(last == change::CREATED)
+                return;
+
+            ///replaced, eg by a rename over the top of it
+            if(last == change::REMOVED && type == change::CREATED)
+            {
+                last = change::MODIFIED;
+                return;
+            }
+
+            last = type;
+        }
+
+        void wake()
+        {
+            #ifdef USE_INOTIFY
+            if(wake_fd != -1)
+            {
+                uint64_t one = 1;
+                [[maybe_unused]] ssize_t unused = ::write(wake_fd, &one, sizeof(one));
+            }
+            #endif // USE_INOTIFY
+
+            cv.notify_all();
+        }
+
+        ///call with the lock held. The watcher's thread takes the first snapshot, outside the lock
+        void fall_back_to_scanning()
+        {
+            if(!native)
+                return;
+
+            native = false;
+
+            #ifdef USE_INOTIFY
+            for(auto& [wd, dir] : watches)
+            {
+                inotify_rm_watch(inotify_fd, wd);
+            }
+
+            for(auto& [wd, w] : waiting)
+            {
+                if(watches.find(wd) == watches.end())
+                    inotify_rm_watch(inotify_fd, wd);
+            }
+
+            watches.clear();
+            waiting.clear();
+            #endif // USE_INOTIFY
+
+            snapshot.clear();
+            unbaselined.clear();
+
+            for(const watched_directory& dir : roots)
+            {
+                unbaselined.push_back(dir.path);
+            }
+
+            wake();
+        }
+
+        ///call with the lock held
+        bool is_rescan_due()
+        {
+            return !native && (unbaselined.size() > 0 || since_last_scan.get_elapsed_time_s() >= poll_interval_s);
+        }
+
+        #ifdef USE_INOTIFY
+        ///call with the lock held. Files already inside directories which appear after the watch started are reported as created
+        ///false if the directory doesn't exist
+        bool add_watch(const watched_directory& dir, bool report_contents)
+        {
+            if(!native)
+                return true;
+
+            uint32_t mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_ONLYDIR;
+
+            int wd = inotify_add_watch(inotify_fd, dir.path.c_str(), mask);
+
+            if(wd == -1)
+            {
+                ///out of watches
+                if(errno == ENOSPC || errno == ENOMEM)
+                    fall_back_to_scanning();
+
+                return errno != ENOENT;
+            }
+
+            watches[wd] = dir;
+
+            for_each_in_directory(dir.path, [&](const std::string& file, const tinydir_file& f)
+            {
+                if(report_contents)
+                    note(file, change::CREATED);
+
+                if(f.is_dir && dir.recursive)
+                    add_watch({file, true}, report_contents);
+            });
+
+            return true;
+        }
+
+        ///call with the lock held. For a root which doesn't exist yet, watches the nearest parent which does, to find out when the next step down appears
+        void wait_for_root(const watched_directory& root)
+        {
+            if(!native)
+                return;
+
+            std::string parent = root.path;
+
+            while(parent != "." && parent != "/")
+            {
+                std::string child = parent;
+                parent = parent_of(parent);
+
+                ///IN_MASK_ADD, as the parent may already be watched for something else
+                int wd = inotify_add_watch(inotify_fd, parent.c_str(), IN_CREATE | IN_MOVED_TO | IN_ONLYDIR | IN_MASK_ADD);
+
+                if(wd != -1)
+                {
+                    waiting_roots& w = waiting[wd];
+                    w.parent = parent;
+                    w.roots.push_back(root);
+
+                    ///it may have been created before the watch was in place
+                    if(file::stat(child).is_dir)
+                        check_waiting(wd, child.substr(child.find_last_of("/\\") + 1), false);
+
+                    return;
+                }
+
+                if(errno == ENOSPC || errno == ENOMEM)
+                {
+                    fall_back_to_scanning();
+                    return;
+                }
+
+                ///eg a permissions problem, which waiting won't fix
+                if(errno != ENOENT)
+                    return;
+            }
+        }
+
+        ///call with the lock held
+        void add_root_watch(const watched_directory& root, bool report_contents)
+        {
+            if(!add_watch(root, report_contents))
+                wait_for_root(root);
+        }
+
+        ///call with the lock held. Roots which the directory that appeared leads to get watched, or wait on it if they're still further down
+        ///if the parent itself has gone, its roots go back to waiting on whatever is left above it
+        void check_waiting(int wd, const std::string& name, bool parent_gone)
+        {
+            auto it = waiting.find(wd);
+
+            if(it == waiting.end())
+                return;
+
+            waiting_roots& w = it->second;
+
+            std::string created = w.parent == "." ? name : (w.parent == "/" ? "/" + name : w.parent + "/" + name);
+
+            std::vector<watched_directory> ready;
+
+            for(int i=0; i < (int)w.roots.size(); i++)
+            {
+                const watched_directory& root = w.roots[i];
+
+                if(!parent_gone && root.path != created && !is_inside(root.path, created))
+                    continue;
+
+                ready.push_back(root);
+                w.roots.erase(w.roots.begin() + i);
+                i--;
+            }
+
+            if(w.roots.size() == 0)
+            {
+                ///the kernel drops the watch itself when the parent goes away
+                if(!parent_gone && watches.find(wd) == watches.end())
+                    inotify_rm_watch(inotify_fd, wd);
+
+                waiting.erase(it);
+            }
+
+            for(const watched_directory& root : ready)
+            {
+                add_root_watch(root, true);
+            }
+        }
+
+        void read_events()
+        {
+            alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+
+            while(1)
+            {
+                ssize_t len = ::read(inotify_fd, buffer, sizeof(buffer));
+
+                if(len <= 0)
+                    return;
+
+                std::lock_guard guard(lock);
+
+                for(char* ptr = buffer; ptr < buffer + len;)
+                {
+                    inotify_event* evt = (inotify_event*)ptr;
+                    ptr += sizeof(inotify_event) + evt->len;
+
+                    ///the kernel dropped events, so anything could have changed
+                    if(evt->mask & IN_Q_OVERFLOW)
+                    {
+                        for(const watched_directory& dir : roots)
+                        {
+                            note(dir.path, change::MODIFIED);
+                        }
+
+                        continue;
+                    }
+
+                    ///a directory appearing might be, or lead to, a missing root
+                    if(((evt->mask & (IN_CREATE | IN_MOVED_TO)) && (evt->mask & IN_ISDIR) && evt->len > 0) || (evt->mask & IN_IGNORED))
+                        check_waiting(evt->wd, evt->len > 0 ? std::string(evt->name) : std::string(), (evt->mask & IN_IGNORED) != 0);
+
+                    auto it = watches.find(evt->wd);
+
+                    if(it == watches.end())
+                        continue;
+
+                    if(evt->mask & IN_IGNORED)
+                    {
+                        watched_directory dir = it->second;
+                        watches.erase(it);
+
+                        ///a root which was deleted gets watched again if it comes back
+                        if(std::any_of(roots.begin(), roots.end(), [&](const watched_directory& root){return root.path == dir.path;}))
+                            wait_for_root(dir);
+
+                        continue;
+                    }
+
+                    if(evt->len == 0)
+                        continue;
+
+                    watched_directory dir = it->second;
+                    std::string file = dir.path + "/" + std::string(evt->name);
+
+                    if(evt->mask & (IN_CREATE | IN_MOVED_TO))
+                    {
+                        note(file, change::CREATED);
+
+                        if((evt->mask & IN_ISDIR) && dir.recursive)
+                            add_watch({file, true}, true);
+                    }
+
+                    if(evt->mask & (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB))
+                        note(file, change::MODIFIED);
+
+                    if(evt->mask & (IN_DELETE | IN_MOVED_FROM))
+                        note(file, change::REMOVED);
+                }
+            }
+        }
+
+        void wait_native(double timeout_s)
+        {
+            pollfd fds[2] = {};
+            fds[0].fd = inotify_fd;
+            fds[0].events = POLLIN;
+            fds[1].fd = wake_fd;
+            fds[1].events = POLLIN;
+
+            int timeout_ms = timeout_s < 0 ? -1 : (int)std::ceil(timeout_s * 1000);
+
+            if(poll(fds, 2, timeout_ms) <= 0)
+                return;
+
+            if(fds[1].revents & POLLIN)
+            {
+                uint64_t count = 0;
+                [[maybe_unused]] ssize_t unused = ::read(wake_fd, &count, sizeof(count));
+            }
+
+            if(fds[0].revents & POLLIN)
+                read_events();
+        }
+        #endif // USE_INOTIFY
+
+        void rescan()
+        {
+            std::vector<watched_directory> to_scan;
+            std::vector<std::string> fresh;
+
+            {
+                std::lock_guard guard(lock);
+                to_scan = roots;
+                fresh = std::move(unbaselined);
+                unbaselined.clear();
+            }
+
+            std::unordered_map<std::string, scanned_file> next;
+
+            for(const watched_directory& dir : to_scan)
+            {
+                scan(dir, next);
+            }
+
+            auto is_fresh = [&](const std::string& file)
+            {
+                return std::any_of(fresh.begin(), fresh.end(), [&](const std::string& root){return is_inside(file, root);});
+            };
+
+            std::lock_guard guard(lock);
+
+            ///roots may have changed while scanning, but the differences are still right for the ones that remain
+            for(auto& [file, now] : next)
+            {
+                auto it = snapshot.find(file);
+
+                if(it == snapshot.end())
+                {
+                    if(!is_fresh(file))
+                        note(file, change::CREATED);
+                }
+                else if(!now.is_dir && (it->second.size != now.size || it->second.mtime_ns != now.mtime_ns))
+                    note(file, change::MODIFIED);
+            }
+
+            for(auto& [file, last] : snapshot)
+            {
+                if(next.find(file) == next.end())
+                    note(file, change::REMOVED);
+            }
+
+            snapshot = std::move(next);
+            since_last_scan.restart();
+        }
+
+        void deliver_if_settled()
+        {
+            std::vector<change_event> changes;
+            std::function<void(const std::vector<change_event>&)> func;
+
+            {
+                std::lock_guard guard(lock);
+
+                if(pending.size() == 0 || since_last_change.get_elapsed_time_s() < debounce_s)
+                    return;
+
+                for(auto& [file, type] : pending)
+                {
+                    changes.push_back({file, type});
+                }
+
+                pending.clear();
+
+                std::sort(changes.begin(), changes.end(), [](const change_event& c1, const change_event& c2){return c1.file < c2.file;});
+
+                if(!callback)
+                {
+                    ready.insert(ready.end(), changes.begin(), changes.end());
+                    return;
+                }
+
+                func = callback;
+            }
+
+            func(changes);
+        }
+
+        ///negative means nothing is due
+        double next_timeout_s()
+        {
+            std::lock_guard guard(lock);
+
+            double timeout_s = -1;
+
+            if(!native)
+                timeout_s = unbaselined.size() > 0 ? 0 : std::max(poll_interval_s - since_last_scan.get_elapsed_time_s(), 0.);
+
+            if(pending.size() > 0)
+            {
+                double settle_s = std::max(debounce_s - since_last_change.get_elapsed_time_s(), 0.);
+
+                timeout_s = timeout_s < 0 ? settle_s : std::min(timeout_s, settle_s);
+            }
+
+            return timeout_s;
+        }
+
+        void run()
+        {
+            while(1)
+            {
+                double timeout_s = next_timeout_s();
+
+                #ifdef USE_INOTIFY
+                if(native)
+                {
+                    wait_native(timeout_s);
+                }
+                else
+                #endif // USE_INOTIFY
+                {
+                    std::unique_lock guard(lock);
+
+                    if(!quit)
+                    {
+                        if(timeout_s < 0)
+                            cv.wait(guard);
+                        else
+                            cv.wait_for(guard, std::chrono::duration<double>(timeout_s));
+                    }
+                }
+
+                {
+                    std::lock_guard guard(lock);
+
+                    if(quit)
+                        return;
+                }
+
+                bool rescan_due = false;
+
+                {
+                    std::lock_guard guard(lock);
+                    rescan_due = is_rescan_due();
+                }
+
+                if(rescan_due)
+                    rescan();
+
+                deliver_if_settled();
+            }
+        }
+    };
+}
+
+file::watcher::watcher(double debounce_s, double poll_interval_s) : state(std::make_unique<watcher_state>())
+{
+    state->debounce_s = debounce_s;
+    state->poll_interval_s = poll_interval_s;
+
+    #ifdef USE_INOTIFY
+    state->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    state->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    state->native = state->inotify_fd != -1 && state->wake_fd != -1;
+    #endif // USE_INOTIFY
+
+    #ifndef __EMSCRIPTEN__
+    state->thread = std::thread([st = state.get()](){st->run();});
+    #endif // __EMSCRIPTEN__
+}
+
+file::watcher::~watcher()
+{
+    {
+        std::lock_guard guard(state->lock);
+        state->quit = true;
+    }
+
+    state->wake();
+
+    if(state->thread.joinable())
+        state->thread.join();
+
+    #ifdef USE_INOTIFY
+    if(state->inotify_fd != -1)
+        close(state->inotify_fd);
+
+    if(state->wake_fd != -1)
+        close(state->wake_fd);
+    #endif // USE_INOTIFY
+}
+
+void file::watcher::add(const std::string& directory, bool recursive)
+{
+    watched_directory dir = {strip_trailing_slash(directory), recursive};
+
+    ///so that everything which already exists isn't reported as created. Scanned before taking the lock, so the watcher's thread isn't held up
+    std::optional<std::unordered_map<std::string, scanned_file>> existing;
+
+    if(!state->native)
+    {
+        existing.emplace();
+        scan(dir, existing.value());
+    }
+
+    std::lock_guard guard(state->lock);
+
+    state->roots.push_back(dir);
+
+    #ifdef USE_INOTIFY
+    if(state->native)
+    {
+        state->add_root_watch(dir, false);
+        return;
+    }
+    #endif // USE_INOTIFY
+
+    ///it fell back to scanning in the meantime
+    if(!existing.has_value())
+    {
+        state->unbaselined.push_back(dir.path);
+        state->wake();
+        return;
+    }
+
+    for(auto& [file, scanned] : existing.value())
+    {
+        state->snapshot.try_emplace(file, scanned);
+    }
+}
+
+void file::watcher::remove(const std::string& directory)
+{
+    std::string path = strip_trailing_slash(directory);
+
+    std::lock_guard guard(state->lock);
+
+    state->roots.erase(std::remove_if(state->roots.begin(), state->roots.end(), [&](const watched_directory& dir){return dir.path == path;}), state->roots.end());
+
+    #ifdef USE_INOTIFY
+    for(auto it = state->watches.begin(); it != state->watches.end();)
+    {
+        if(it->second.path == path || is_inside(it->second.path, path))
+        {
+            inotify_rm_watch(state->inotify_fd, it->first);
+            it = state->watches.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+
+    for(auto it = state->waiting.begin(); it != state->waiting.end();)
+    {
+        std::vector<watched_directory>& dirs = it->second.roots;
+
+        dirs.erase(std::remove_if(dirs.begin(), dirs.end(), [&](const watched_directory& dir){return dir.path == path;}), dirs.end());
+
+        if(dirs.size() > 0)
+        {
+            it++;
+            continue;
+        }
+
+        if(state->watches.find(it->first) == state->watches.end())
+            inotify_rm_watch(state->inotify_fd, it->first);
+
+        it = state->waiting.erase(it);
+    }
+    #endif // USE_INOTIFY
+
+    state->unbaselined.erase(std::remove(state->unbaselined.begin(), state->unbaselined.end(), path), state->unbaselined.end());
+
+    for(auto it = state->snapshot.begin(); it != state->snapshot.end();)
+    {
+        if(is_inside(it->first, path))
+            it = state->snapshot.erase(it);
+        else
+            it++;
+    }
+
+    for(auto it = state->pending.begin(); it != state->pending.end();)
+    {
+        if(is_inside(it->first, path))
+            it = state->pending.erase(it);
+        else
+            it++;
+    }
+}
+
+void file::watcher::set_callback(std::function<void(const std::vector<change_event>&)> on_changes)
+{
+    std::lock_guard guard(state->lock);
+
+    state->callback = std::move(on_changes);
+}
+
+std::vector<file::change_event> file::watcher::take_changes()
+{
+    std::lock_guard guard(state->lock);
+
+    std::vector<change_event> ret = std::move(state->ready);
+    state->ready.clear();
+
+    return ret;
+}
+
+bool file::watcher::is_native()
+{
+    return state->native;
+}
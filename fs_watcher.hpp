@@ -0,0 +1,58 @@
+#ifndef FS_WATCHER_HPP_INCLUDED
+#define FS_WATCHER_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+namespace file
+{
+    namespace change
+    {
+        enum type
+        {
+            CREATED,
+            MODIFIED,
+            REMOVED
+        };
+    }
+
+    struct change_event
+    {
+        ///the directory as it was added, joined with the file's name, eg assets/textures/a.png
+        std::string file;
+        change::type type = change::MODIFIED;
+    };
+
+    struct watcher_state;
+
+    ///watches directories for changes on a background thread, with inotify on linux, and by rescanning everything else. Emscripten reports nothing
+    ///changes are coalesced per file, and only handed out once debounce_s has passed without any further change
+    ///eg a file being written in several pieces arrives as one MODIFIED, and a temporary file created and deleted again doesn't arrive at all
+    struct watcher
+    {
+        watcher(double debounce_s = 0.1, double poll_interval_s = 1);
+        ~watcher();
+
+        watcher(const watcher&) = delete;
+        watcher& operator=(const watcher&) = delete;
+
+        ///recursive also picks up subdirectories created later. A directory which doesn't exist yet is picked up once it's created
+        void add(const std::string& directory, bool recursive = false);
+        void remove(const std::string& directory);
+
+        ///called on the watcher's thread with each debounced set of changes. Without one, changes queue up for take_changes
+        void set_callback(std::function<void(const std::vector<change_event>&)> on_changes);
+        ///thread safe
+        std::vector<change_event> take_changes();
+
+        ///false if this is rescanning, eg inotify's watch limit has been hit
+        bool is_native();
+
+    private:
+        std::unique_ptr<watcher_state> state;
+    };
+}
+
+#endif // FS_WATCHER_HPP_INCLUDED
@@ -0,0 +1,169 @@
+#include "gl_shader.hpp"
+#include <GL/glew.h>
+#include <GL/gl.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+    #ifndef __EMSCRIPTEN__
+    const char* version_header = "#version 130\n";
+    #else
+    const char* version_header = "#version 100\nprecision mediump float;\n";
+    #endif
+
+    const char* vertex_source = R"(
+attribute vec2 position;
+varying vec2 uv;
+
+void main()
+{
+    uv = position * 0.5 + 0.5;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
+)";
+
+    ///gl thread only
+    unsigned int quad_buffer = 0;
+
+    unsigned int compile(GLenum type, const std::string& source)
+    {
+        unsigned int shader = glCreateShader(type);
+
+        std::string full = version_header + source;
+        const char* ptr = full.c_str();
+
+        glShaderSource(shader, 1, &ptr, nullptr);
+        glCompileShader(shader);
+
+        GLint status = 0;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+
+        if(status != GL_TRUE)
+        {
+            GLint length = 0;
+            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+
+            std::string log;
+            log.resize(std::max(length, 1));
+
+            glGetShaderInfoLog(shader, log.size(), nullptr, &log[0]);
+
+            std::cout << "Shader compile failed " << log << std::endl;
+
+            glDeleteShader(shader);
+            return 0;
+        }
+
+        return shader;
+    }
+}
+
+gl_shader::gl_shader()
+{
+
+}
+
+gl_shader::~gl_shader()
+{
+    if(program != 0)
+        glDeleteProgram(program);
+}
+
+bool gl_shader::load(const std::string& fragment_source)
+{
+    if(program != 0)
+    {
+        glDeleteProgram(program);
+        program = 0;
+    }
+
+    unsigned int vertex = compile(GL_VERTEX_SHADER, vertex_source);
+    unsigned int fragment = compile(GL_FRAGMENT_SHADER, fragment_source);
+
+    if(vertex == 0 || fragment == 0)
+    {
+        if(vertex != 0)
+            glDeleteShader(vertex);
+
+        if(fragment != 0)
+            glDeleteShader(fragment);
+
+        return false;
+    }
+
+    program = glCreateProgram();
+
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+
+    glBindAttribLocation(program, 0, "position");
+
+    glLinkProgram(program);
+
+    glDetachShader(program, vertex);
+    glDetachShader(program, fragment);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+    if(status != GL_TRUE)
+    {
+        std::cout << "Shader link failed" << std::endl;
+
+        glDeleteProgram(program);
+        program = 0;
+        return false;
+    }
+
+    return true;
+}
+
+bool gl_shader::is_valid()
+{
+    return program != 0;
+}
+
+void gl_shader::bind()
+{
+    glUseProgram(program);
+}
+
+void gl_shader::set_uniform(const std::string& name, int val)
+{
+    glUniform1i(glGetUniformLocation(program, name.c_str()), val);
+}
+
+void gl_shader::set_uniform(const std::string& name, float val)
+{
+    glUniform1f(glGetUniformLocation(program, name.c_str()), val);
+}
+
+void gl_shader::set_uniform(const std::string& name, vec2f val)
+{
+    glUniform2f(glGetUniformLocation(program, name.c_str()), val.x(), val.y());
+}
+
+void gl_shader::draw_fullscreen()
+{
+    if(quad_buffer == 0)
+    {
+        float verts[] = {-1, -1, 1, -1, -1, 1, 1, 1};
+
+        glGenBuffers(1, &quad_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, quad_buffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, quad_buffer);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glDisableVertexAttribArray(0);
+}
@@ -0,0 +1,33 @@
+#ifndef GL_SHADER_HPP_INCLUDED
+#define GL_SHADER_HPP_INCLUDED
+
+#include <string>
+#include <vec/vec.hpp>
+
+///a program made of the shared fullscreen quad vertex shader, and a fragment shader
+///the fragment shader gets a vec2 varying called uv, and is written in glsl 1.00 style so that it also works under webgl
+struct gl_shader
+{
+    unsigned int program = 0;
+
+    gl_shader();
+    ~gl_shader();
+
+    gl_shader(const gl_shader&) = delete;
+    gl_shader& operator=(const gl_shader&) = delete;
+
+    ///returns false rather than throwing, so that this can be used to probe for support
+    bool load(const std::string& fragment_source);
+    bool is_valid();
+
+    void bind();
+
+    void set_uniform(const std::string& name, int val);
+    void set_uniform(const std::string& name, float val);
+    void set_uniform(const std::string& name, vec2f val);
+
+    ///covers the whole of the current viewport
+    void draw_fullscreen();
+};
+
+#endif // GL_SHADER_HPP_INCLUDED
@@ -37,3 +37,103 @@ void blur_image(__read_only image2d_t read_buf, __write_only image2d_t write_buf
 
     write_imagef(write_buf, (int2){x, y}, out);
 }
+
+///dual kawase. Each downsample halves the resolution, and samples the centre + 4 diagonals of the level above with bilinear filtering
+__kernel
+void frost_downsample(__read_only image2d_t read_buf, __write_only image2d_t write_buf, int w, int h, float offset)
+{
+    sampler_t sam = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR;
+
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+
+    if(x >= w || y >= h)
+        return;
+
+    float2 src_dim = (float2){get_image_width(read_buf), get_image_height(read_buf)};
+    float2 scale = src_dim / (float2){w, h};
+
+    ///unnormalised coordinates sample texel centres at +0.5
+    float2 centre = ((float2){x, y} + 0.5f) * scale;
+
+    float4 sum = read_imagef(read_buf, sam, centre) * 4.f;
+
+    sum += read_imagef(read_buf, sam, centre + (float2){-offset, -offset});
+    sum += read_imagef(read_buf, sam, centre + (float2){offset, -offset});
+    sum += read_imagef(read_buf, sam, centre + (float2){-offset, offset});
+    sum += read_imagef(read_buf, sam, centre + (float2){offset, offset});
+
+    write_imagef(write_buf, (int2){x, y}, sum / 8.f);
+}
+
+///dual kawase upsample, a tent of 8 bilinear samples from the smaller level
+__kernel
+void frost_upsample(__read_only image2d_t read_buf, __write_only image2d_t write_buf, int w, int h, float offset)
+{
+    sampler_t sam = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR;
+
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+
+    if(x >= w || y >= h)
+        return;
+
+    float2 src_dim = (float2){get_image_width(read_buf), get_image_height(read_buf)};
+    float2 scale = src_dim / (float2){w, h};
+
+    float2 centre = ((float2){x, y} + 0.5f) * scale;
+
+    float half_offset = offset * 0.5f;
+
+    float4 sum = 0;
+
+    sum += read_imagef(read_buf, sam, centre + (float2){-offset, 0});
+    sum += read_imagef(read_buf, sam, centre + (float2){offset, 0});
+    sum += read_imagef(read_buf, sam, centre + (float2){0, -offset});
+    sum += read_imagef(read_buf, sam, centre + (float2){0, offset});
+
+    sum += read_imagef(read_buf, sam, centre + (float2){-half_offset, -half_offset}) * 2.f;
+    sum += read_imagef(read_buf, sam, centre + (float2){half_offset, -half_offset}) * 2.f;
+    sum += read_imagef(read_buf, sam, centre + (float2){-half_offset, half_offset}) * 2.f;
+    sum += read_imagef(read_buf, sam, centre + (float2){half_offset, half_offset}) * 2.f;
+
+    write_imagef(write_buf, (int2){x, y}, sum / 12.f);
+}
+
+///writes the blurred image back into the screen, but only inside the frosted rects. Rects are x, y, w, h in image coordinates
+///launched once over the bounding box of every rect, rather than once per window
+__kernel
+void frost_composite(__read_only image2d_t blurred, __write_only image2d_t write_buf, __global const int4* rects, int rect_count, int w, int h, int ox, int oy)
+{
+    sampler_t sam = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR;
+
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+
+    if(x >= w || y >= h)
+        return;
+
+    x += ox;
+    y += oy;
+
+    if(x < 0 || y < 0 || x >= get_image_width(write_buf) || y >= get_image_height(write_buf))
+        return;
+
+    bool inside = false;
+
+    for(int i=0; i < rect_count; i++)
+    {
+        int4 r = rects[i];
+
+        inside = inside || (x >= r.x && y >= r.y && x < r.x + r.z && y < r.y + r.w);
+    }
+
+    if(!inside)
+        return;
+
+    float2 scale = (float2){get_image_width(blurred), get_image_height(blurred)} / (float2){get_image_width(write_buf), get_image_height(write_buf)};
+
+    float4 out = read_imagef(blurred, sam, ((float2){x, y} + 0.5f) * scale);
+
+    write_imagef(write_buf, (int2){x, y}, clamp(out, 0.f, 1.f));
+}
@@ -1451,11 +1451,31 @@ void cl::command_queue::flush()
     clFlush(native_command_queue.data);
 }
 
+static
+clCreateEventFromGLsyncKHR_fn get_create_event_from_glsync(cl_device_id device)
+{
+    ///only one platform is ever selected, so this can be cached
+    static clCreateEventFromGLsyncKHR_fn func = [&]()
+    {
+        cl_platform_id platform = nullptr;
+
+        if(clGetDeviceInfo(device, CL_DEVICE_PLATFORM, sizeof(platform), &platform, nullptr) != CL_SUCCESS)
+            return (clCreateEventFromGLsyncKHR_fn)nullptr;
+
+        return (clCreateEventFromGLsyncKHR_fn)clGetExtensionFunctionAddressForPlatform(platform, "clCreateEventFromGLsyncKHR");
+    }();
+
+    return func;
+}
+
 cl::gl_rendertexture::gl_rendertexture(context& ctx)
 {
     native_context = ctx.native_context;
 
     sharing_is_available = cl::supports_extension(ctx, "cl_khr_gl_sharing");
+
+    if(sharing_is_available && cl::supports_extension(ctx, "cl_khr_gl_event"))
+        gl_event_is_available = get_create_event_from_glsync(ctx.selected_device) != nullptr;
 }
 
 void cl::gl_rendertexture::create(int _w, int _h)
@@ -1635,8 +1655,39 @@ cl::event cl::gl_rendertexture::acquire(cl::command_queue& cqueue, const std::ve
     acquired = true;
 
     if(sharing_is_available)
+    {
+        ///gl has to have finished writing to the texture before cl reads it. A fence only covers the gl work issued before this point, rather than draining everything like glFinish
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        cl_event gl_done = nullptr;
+
+        if(gl_event_is_available)
+        {
+            cl_int err = CL_SUCCESS;
+
+            ///already resolved by the constructor, so the device isn't needed
+            gl_done = get_create_event_from_glsync(nullptr)(native_context.data, (cl_GLsync)fence, &err);
+
+            if(err != CL_SUCCESS)
+                gl_done = nullptr;
+        }
+
+        ///with cl_khr_gl_event the wait happens on the device, otherwise the cpu blocks on the fence until gl has caught up
+        if(gl_done != nullptr)
+            events.push_back(gl_done);
+        else
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+
         clEnqueueAcquireGLObjects(cqueue.native_command_queue.data, 1, &native_mem_object.data, events.size(), events.data(), &ret.native_event.data);
 
+        ///the cl event holds its own reference to the sync object
+        if(gl_done != nullptr)
+            clReleaseEvent(gl_done);
+
+        glDeleteSync(fence);
+    }
+
     return ret;
 }
 
@@ -1659,6 +1710,25 @@ cl::event cl::gl_rendertexture::unacquire(cl::command_queue& cqueue, const std::
     if(sharing_is_available)
     {
         clEnqueueReleaseGLObjects(cqueue.native_command_queue.data, 1, &native_mem_object.data, events.size(), events.data(), &ret.native_event.data);
+
+        clFlush(cqueue.native_command_queue.data);
+
+        ///gl must not touch the texture until cl has released it. With GL_ARB_cl_event the gl server waits on the release
+        ///otherwise the cpu has to wait for it, and on an in order queue that means everything enqueued before it too. There's nowhere later to put that wait, as gl draws into the texture straight after
+        GLsync release = nullptr;
+
+        if(GLEW_ARB_cl_event)
+            release = glCreateSyncFromCLeventARB(native_context.data, ret.native_event.data, 0);
+
+        if(release != nullptr)
+        {
+            glWaitSync(release, 0, GL_TIMEOUT_IGNORED);
+            glDeleteSync(release);
+        }
+        else
+        {
+            ret.block();
+        }
     }
     else
     {
@@ -809,6 +809,8 @@ namespace cl
     struct gl_rendertexture : image_base
     {
         bool sharing_is_available = false;
+        ///cl_khr_gl_event, lets cl wait on a gl fence without stalling the cpu
+        bool gl_event_is_available = false;
         bool acquired = false;
         base<cl_context, clRetainContext, clReleaseContext> native_context;
 
@@ -821,6 +823,8 @@ namespace cl
         void create_from_texture_with_mipmaps(GLuint texture_id, int mip_level);
         void create_from_framebuffer(GLuint framebuffer_id);
 
+        ///these synchronise with gl through sync objects, so no glFinish is needed around them
+        ///they only avoid stalling the cpu with cl_khr_gl_event (acquire) and GL_ARB_cl_event (unacquire). Without those, the cpu waits for gl or the cl queue to catch up
         event acquire(command_queue& cqueue);
         event unacquire(command_queue& cqueue);
 
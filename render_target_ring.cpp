@@ -0,0 +1,147 @@
+#include "render_target_ring.hpp"
+#include <GL/glew.h>
+#include <GL/gl.h>
+#include <algorithm>
+
+namespace
+{
+    void make_fbo(unsigned int* fboptr, unsigned int* tex, vec2i dim)
+    {
+        int wx = dim.x();
+        int wy = dim.y();
+
+        glGenFramebuffers(1, fboptr);
+        glBindFramebuffer(GL_FRAMEBUFFER, *fboptr);
+
+        glGenTextures(1, tex);
+        glBindTexture(GL_TEXTURE_2D, *tex);
+
+        #ifndef __EMSCRIPTEN__
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, wx, wy, 0, GL_RGBA, GL_FLOAT, NULL);
+        #else
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, wx, wy, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        #endif
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *tex, 0);
+    }
+
+    void wait_and_release(frame_target& target)
+    {
+        if(target.fence == nullptr)
+            return;
+
+        #ifndef __EMSCRIPTEN__
+        GLsync fence = (GLsync)target.fence;
+
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(fence);
+        #endif
+
+        target.fence = nullptr;
+    }
+}
+
+render_target_ring::render_target_ring()
+{
+
+}
+
+render_target_ring::~render_target_ring()
+{
+    destroy();
+}
+
+void render_target_ring::create(int count, vec2i _dim)
+{
+    destroy();
+
+    ///webgl has no client side waits, so there's nothing to gain
+    #ifdef __EMSCRIPTEN__
+    count = 1;
+    #endif
+
+    count = std::max(count, 1);
+
+    dim = _dim;
+    counter = 0;
+
+    targets.resize(count);
+
+    for(frame_target& target : targets)
+    {
+        make_fbo(&target.fbo, &target.tex, dim);
+    }
+}
+
+void render_target_ring::destroy()
+{
+    for(frame_target& target : targets)
+    {
+        wait_and_release(target);
+
+        glDeleteFramebuffers(1, &target.fbo);
+        glDeleteTextures(1, &target.tex);
+    }
+
+    targets.clear();
+    counter = 0;
+}
+
+frame_target& render_target_ring::acquire()
+{
+    frame_target& target = get();
+
+    wait_and_release(target);
+
+    return target;
+}
+
+void render_target_ring::release()
+{
+    #ifndef __EMSCRIPTEN__
+    if(targets.size() > 1)
+    {
+        frame_target& target = get();
+
+        if(target.fence != nullptr)
+            glDeleteSync((GLsync)target.fence);
+
+        target.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    #endif
+
+    counter = (counter + 1) % size();
+}
+
+frame_target& render_target_ring::get()
+{
+    return targets[counter];
+}
+
+frame_target& render_target_ring::last()
+{
+    return targets[(counter + size() - 1) % size()];
+}
+
+frame_target& render_target_ring::get_nth(int index)
+{
+    return targets[index];
+}
+
+int render_target_ring::get_index()
+{
+    return counter;
+}
+
+int render_target_ring::size()
+{
+    return targets.size();
+}
+
+vec2i render_target_ring::get_dim()
+{
+    return dim;
+}
@@ -0,0 +1,56 @@
+#ifndef RENDER_TARGET_RING_HPP_INCLUDED
+#define RENDER_TARGET_RING_HPP_INCLUDED
+
+#include <vec/vec.hpp>
+#include <vector>
+
+///an offscreen colour target that a frame is rendered into, before being presented
+struct frame_target
+{
+    unsigned int fbo = 0;
+    unsigned int tex = 0;
+
+    ///GLsync, signalled once the gpu has finished the frame that last used this target
+    void* fence = nullptr;
+};
+
+///a runtime sized version of cl::flip for frame targets, where each target is fenced after being presented
+///the cpu can get up to size() - 1 frames ahead of the gpu before acquire blocks
+struct render_target_ring
+{
+    render_target_ring();
+    ~render_target_ring();
+
+    render_target_ring(const render_target_ring&) = delete;
+    render_target_ring& operator=(const render_target_ring&) = delete;
+
+    ///gl thread only. Recreates every target, count is clamped to at least 1
+    void create(int count, vec2i dim);
+    void destroy();
+
+    ///waits until the gpu is done with the current target, then returns it
+    frame_target& acquire();
+
+    ///fences the current target, and moves on to the next one
+    void release();
+
+    ///the current target, which is acquired and not yet released
+    frame_target& get();
+
+    ///the last target to be released, ie the last presented frame
+    frame_target& last();
+
+    frame_target& get_nth(int index);
+
+    int get_index();
+    int size();
+
+    vec2i get_dim();
+
+private:
+    std::vector<frame_target> targets;
+    int counter = 0;
+    vec2i dim;
+};
+
+#endif // RENDER_TARGET_RING_HPP_INCLUDED
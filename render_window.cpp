@@ -1,5 +1,7 @@
 #include "render_window.hpp"
 #include "texture.hpp"
+#include "texture_atlas.hpp"
+#include "frost.hpp"
 #include "vertex.hpp"
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
@@ -11,6 +13,19 @@
 #include "render_window_glfw.hpp"
 #include "clipboard.hpp"
 #include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+#include <string.h>
+#include <type_traits>
+
+#ifdef USE_HEADLESS
+#include "render_window_headless.hpp"
+#endif // USE_HEADLESS
 
 #ifdef USE_IMTUI
 #include <imtui/imtui.h>
@@ -28,48 +43,167 @@
 
 namespace
 {
-    thread_local std::map<std::string, bool> frost_map;
-}
+    ///sorted, so that lookups and inserts are a binary search over a flat array
+    thread_local std::vector<ImGuiID> frost_ids;
 
+    struct frost_rect_f
+    {
+        ImVec2 pos;
+        ImVec2 size;
 
-#ifdef __EMSCRIPTEN__
-std::string fixup_string(std::string in)
-{
-    if(in.size() == 0)
-        return in;
+        bool operator==(const frost_rect_f& other) const
+        {
+            return pos.x == other.pos.x && pos.y == other.pos.y && size.x == other.size.x && size.y == other.size.y;
+        }
+    };
+
+    ///the window rects that produced cached_frostables, so that the merge is only redone when a frosted window moves or resizes
+    thread_local std::vector<frost_rect_f> cached_window_rects;
+    thread_local std::vector<frostable> cached_frostables;
+
+    ///cuts cut out of r, leaving up to 4 pieces that don't overlap it
+    void subtract_rect(const frost_rect_f& r, const frost_rect_f& cut, std::vector<frost_rect_f>& out)
+    {
+        float rx1 = r.pos.x + r.size.x;
+        float ry1 = r.pos.y + r.size.y;
+        float cx1 = cut.pos.x + cut.size.x;
+        float cy1 = cut.pos.y + cut.size.y;
+
+        if(cut.pos.x >= rx1 || cx1 <= r.pos.x || cut.pos.y >= ry1 || cy1 <= r.pos.y)
+        {
+            out.push_back(r);
+            return;
+        }
+
+        float top = std::max(r.pos.y, cut.pos.y);
+        float bottom = std::min(ry1, cy1);
 
-    int clen = strlen(in.c_str());
+        if(cut.pos.y > r.pos.y)
+            out.push_back({r.pos, {r.size.x, cut.pos.y - r.pos.y}});
 
-    in.resize(clen);
+        if(cy1 < ry1)
+            out.push_back({{r.pos.x, cy1}, {r.size.x, ry1 - cy1}});
 
-    return in;
+        if(cut.pos.x > r.pos.x)
+            out.push_back({{r.pos.x, top}, {cut.pos.x - r.pos.x, bottom - top}});
+
+        if(cx1 < rx1)
+            out.push_back({{cx1, top}, {rx1 - cx1, bottom - top}});
+    }
+
+    ///overlapping windows would otherwise get blurred more than once
+    std::vector<frost_rect_f> make_disjoint(const std::vector<frost_rect_f>& rects)
+    {
+        std::vector<frost_rect_f> ret;
+
+        for(const frost_rect_f& r : rects)
+        {
+            std::vector<frost_rect_f> pieces = {r};
+
+            for(const frost_rect_f& existing : ret)
+            {
+                std::vector<frost_rect_f> next;
+
+                for(const frost_rect_f& piece : pieces)
+                {
+                    subtract_rect(piece, existing, next);
+                }
+
+                pieces = std::move(next);
+            }
+
+            for(const frost_rect_f& piece : pieces)
+            {
+                if(piece.size.x > 0 && piece.size.y > 0)
+                    ret.push_back(piece);
+            }
+        }
+
+        return ret;
+    }
 }
 
-EM_JS(int, num_dropped_files, (),
+
+#ifdef __EMSCRIPTEN__
+namespace
 {
-    return Module.dropped.length;
+    struct web_dropped_file
+    {
+        dropped_file fle;
+        bool done = false;
+    };
+
+    ///files the browser is still copying in, and ones which have finished. Everything here happens on the main thread
+    std::map<int, web_dropped_file> web_dropped;
+    int next_web_dropped_id = 0;
+    uint64_t web_max_size = 0;
+}
+
+EM_JS(int, drag_drop_name_length, (),
+{
+    return lengthBytesUTF8(Module.drop_name);
 });
 
-EM_JS(int, dropped_array_member_length, (int idx, int member),
+EM_JS(void, drag_drop_name, (char* out, int length),
 {
-    return Module.dropped[idx][member].length;
+    stringToUTF8(Module.drop_name, out, length + 1);
 });
 
-EM_JS(void, dropped_array_member, (int idx, int member, char* out),
+///called from javascript. The data is copied straight into the std::string's buffer, so a dropped file is copied exactly once
+extern "C"
 {
-    var member = Module.dropped[idx][member];
+    ///the name is in Module.drop_name
+    EMSCRIPTEN_KEEPALIVE int drag_drop_begin(double size)
+    {
+        int id = next_web_dropped_id++;
 
-    stringToUTF8(member, out, member.length+1);
-});
+        std::string name;
+        name.resize(drag_drop_name_length());
+        drag_drop_name(name.data(), name.size());
+
+        web_dropped_file& web = web_dropped[id];
+        web.fle.name = name;
+        web.fle.size = (uint64_t)size;
+
+        if(web.fle.size > web_max_size)
+        {
+            web.fle.too_large = true;
+            web.done = true;
+            return -1;
+        }
+
+        web.fle.data.resize(web.fle.size);
 
-EM_JS(void, clear_dropped, (),
+        return id;
+    }
+
+    EMSCRIPTEN_KEEPALIVE char* drag_drop_data(int id)
+    {
+        return web_dropped[id].fle.data.data();
+    }
+
+    EMSCRIPTEN_KEEPALIVE void drag_drop_end(int id, int success)
+    {
+        if(!success)
+        {
+            web_dropped.erase(id);
+            return;
+        }
+
+        web_dropped[id].done = true;
+    }
+}
+
+EM_JS(void, drag_drop_progress, (int id, double* bytes_read),
 {
-    Module.dropped = [];
+    var progress = Module.drop_progress[id];
+
+    HEAPF64[bytes_read >> 3] = progress === undefined ? 0 : progress;
 });
 
 EM_JS(void, drag_drop_init, (),
 {
-    Module.dropped = [];
+    Module.drop_progress = {};
 
     function dragenter(e)
     {
@@ -83,27 +217,54 @@ EM_JS(void, drag_drop_init, (),
         e.preventDefault();
     }
 
-    function drop(e)
+    ///large files are read a slice at a time, so the browser never holds more than one chunk of them on top of the wasm heap
+    async function ingest(file)
     {
-        e.stopPropagation();
-        e.preventDefault();
+        const chunk_size = 8 * 1024 * 1024;
 
-        const dt = e.dataTransfer;
-        const all_files = dt.files;
+        Module.drop_name = file.name;
 
-        for(var i=0; i < all_files.length; i++)
-        {
-            const file = all_files[i];
+        const id = _drag_drop_begin(file.size);
 
-            var read = new FileReader();
+        if(id < 0)
+            return;
 
-            read.readAsBinaryString(file);
+        Module.drop_progress[id] = 0;
 
-            read.onloadend = function()
+        try
+        {
+            for(var offset = 0; offset < file.size; offset += chunk_size)
             {
-                Module.dropped.push([file.name, read.result]);
-                console.log(Module.dropped[Module.dropped.length-1]);
+                const chunk = await file.slice(offset, Math.min(offset + chunk_size, file.size)).arrayBuffer();
+
+                ///HEAPU8 is looked up every time, as the heap may have grown while waiting
+                HEAPU8.set(new Uint8Array(chunk), _drag_drop_data(id) + offset);
+
+                Module.drop_progress[id] = offset + chunk.byteLength;
             }
+
+            _drag_drop_end(id, 1);
+        }
+        catch(err)
+        {
+            console.log("Failed to read dropped file " + file.name + " " + err);
+
+            _drag_drop_end(id, 0);
+        }
+
+        delete Module.drop_progress[id];
+    }
+
+    function drop(e)
+    {
+        e.stopPropagation();
+        e.preventDefault();
+
+        const all_files = e.dataTransfer.files;
+
+        for(var i=0; i < all_files.length; i++)
+        {
+            ingest(all_files[i]);
         }
     }
 
@@ -151,10 +312,14 @@ void init_clipboard()
     ImGui::GetIO().SetClipboardTextFn = &set_clipboard_free;
 }
 
-void emscripten_drag_drop::init()
+void emscripten_drag_drop::init(uint64_t max_size)
 {
     #ifdef __EMSCRIPTEN__
+    web_max_size = max_size;
+
     drag_drop_init();
+    #else
+    (void)max_size;
     #endif // __EMSCRIPTEN__
 }
 
@@ -163,106 +328,221 @@ std::vector<dropped_file> emscripten_drag_drop::get_dropped_files()
     std::vector<dropped_file> files;
 
     #ifdef __EMSCRIPTEN__
+    ///ids only increase, so finished files come out in the order they were dropped. One still being read holds back the ones after it
+    for(auto it = web_dropped.begin(); it != web_dropped.end() && it->second.done;)
+    {
+        files.push_back(std::move(it->second.fle));
+        it = web_dropped.erase(it);
+    }
+    #endif // __EMSCRIPTEN__
 
-    int num_files = num_dropped_files();
+    return files;
+}
 
-    for(int array_idx = 0; array_idx < num_files; array_idx++)
+std::vector<dropped_file_progress> emscripten_drag_drop::get_progress()
+{
+    std::vector<dropped_file_progress> ret;
+
+    #ifdef __EMSCRIPTEN__
+    for(auto& [id, web] : web_dropped)
     {
-        int name_length = dropped_array_member_length(array_idx, 0);
-        int data_length = dropped_array_member_length(array_idx, 1);
+        if(web.done)
+            continue;
 
-        std::string name;
-        name.resize(name_length + 1);
+        double bytes_read = 0;
+        drag_drop_progress(id, &bytes_read);
+
+        dropped_file_progress progress;
+        progress.name = web.fle.name;
+        progress.size = web.fle.size;
+        progress.bytes_read = (uint64_t)bytes_read;
+
+        ret.push_back(progress);
+    }
+    #endif // __EMSCRIPTEN__
+
+    return ret;
+}
+
+struct dropped_file_loader_state
+{
+    std::mutex lock;
+    std::condition_variable cv;
+    std::thread worker;
+    bool quit = false;
 
-        std::string data;
-        data.resize(data_length + 1);
+    std::deque<dropped_file> queued;
+    std::vector<dropped_file> finished;
 
-        char* nptr = &name[0];
-        char* dptr = &data[0];
+    ///the file being read, if busy
+    dropped_file_progress current;
+    bool busy = false;
 
-        dropped_array_member(array_idx, 0, nptr);
-        dropped_array_member(array_idx, 1, dptr);
+    void run(dropped_file_loader& loader)
+    {
+        while(1)
+        {
+            dropped_file next;
+
+            {
+                std::unique_lock guard(lock);
+
+                cv.wait(guard, [&](){return quit || queued.size() > 0;});
+
+                if(quit)
+                    return;
+
+                next = std::move(queued.front());
+                queued.pop_front();
+
+                busy = true;
+                current = dropped_file_progress();
+                current.name = next.name;
+            }
+
+            ///a stat, so that a file which is too large is never opened
+            next.size = file::size(next.path);
+
+            {
+                std::lock_guard guard(lock);
+                current.size = next.size;
+            }
 
-        dropped_file next;
-        next.name = fixup_string(name);
-        next.data = fixup_string(data);
+            if(next.size > loader.max_size)
+            {
+                next.too_large = true;
+            }
+            else
+            {
+                file::reader in(next.path, 4 * 1024 * 1024);
+
+                if(in.is_open())
+                {
+                    next.data.reserve(in.size());
+
+                    ///a chunk at a time rather than for_each, so that a large file doesn't hold up shutting down
+                    for(std::string_view chunk = in.next(); chunk.size() > 0; chunk = in.next())
+                    {
+                        ///it grew after it was statted
+                        if(next.data.size() + chunk.size() > loader.max_size)
+                        {
+                            next.too_large = true;
+                            next.data = std::string();
+                            break;
+                        }
+
+                        next.data.append(chunk);
+
+                        std::lock_guard guard(lock);
+
+                        if(quit)
+                            return;
+
+                        current.bytes_read = next.data.size();
+                    }
+
+                    if(!next.too_large)
+                        next.size = next.data.size();
+                }
+            }
+
+            {
+                std::lock_guard guard(lock);
 
-        files.push_back(next);
+                finished.push_back(std::move(next));
+                busy = false;
+            }
+
+            if(loader.on_finished)
+                loader.on_finished();
+        }
     }
+};
 
-    clear_dropped();
+dropped_file_loader::dropped_file_loader() : state(std::make_unique<dropped_file_loader_state>())
+{
 
-    #endif // __EMSCRIPTEN__
+}
 
-    return files;
+dropped_file_loader::~dropped_file_loader()
+{
+    {
+        std::lock_guard guard(state->lock);
+        state->quit = true;
+    }
+
+    state->cv.notify_all();
+
+    if(state->worker.joinable())
+        state->worker.join();
 }
 
-///just realised a much faster version of this
-///unconditionally blur whole screen, then only clip bits we want
-#ifndef NO_OPENCL
-#ifndef NO_OPENCL_SCREEN
-void blur_buffer(render_window& win, cl::gl_rendertexture& tex)
+void dropped_file_loader::add(const std::string& path, const std::string& name)
 {
-    std::vector<frostable> frosty = win.get_frostables();
+    dropped_file fle;
+    fle.name = name;
+    fle.path = path;
 
-    if(frosty.size() == 0)
-        return;
+    {
+        std::lock_guard guard(state->lock);
 
-    glFinish();
+        state->queued.push_back(std::move(fle));
 
-    tex.acquire(win.clctx->cqueue);
+        ///most programs never see a dropped file, so the thread only starts with the first
+        if(!state->worker.joinable())
+            state->worker = std::thread([this](){state->run(*this);});
+    }
 
-    win.clctx->cl_image.clear(win.clctx->cqueue);
+    state->cv.notify_all();
+}
 
-    for(int i=0; i < 80; i++)
-    for(frostable& f : frosty)
-    {
-        int ix = f.pos.x();
-        int iy = win.get_window_size().y() - f.pos.y() - f.dim.y();
+std::vector<dropped_file> dropped_file_loader::take_finished()
+{
+    std::lock_guard guard(state->lock);
 
-        int dx = f.dim.x();
-        int dy = f.dim.y();
+    std::vector<dropped_file> ret = std::move(state->finished);
+    state->finished.clear();
 
-        cl::args blur;
+    return ret;
+}
 
-        blur.push_back(tex);
-        blur.push_back(win.clctx->cl_image);
-        blur.push_back(dx);
-        blur.push_back(dy);
-        blur.push_back(ix);
-        blur.push_back(iy);
+std::vector<dropped_file_progress> dropped_file_loader::get_progress()
+{
+    std::lock_guard guard(state->lock);
 
-        win.clctx->cqueue.exec("blur_image", blur, {dx, dy}, {16, 16});
+    std::vector<dropped_file_progress> ret;
 
-        cl::args blur2;
+    if(state->busy)
+        ret.push_back(state->current);
 
-        blur2.push_back(win.clctx->cl_image);
-        blur2.push_back(tex);
-        blur2.push_back(dx);
-        blur2.push_back(dy);
-        blur2.push_back(ix);
-        blur2.push_back(iy);
+    for(const dropped_file& fle : state->queued)
+    {
+        dropped_file_progress progress;
+        progress.name = fle.name;
 
-        win.clctx->cqueue.exec("blur_image", blur2, {dx, dy}, {16, 16});
+        ret.push_back(progress);
     }
 
-    tex.unacquire(win.clctx->cqueue);
-    win.clctx->cqueue.block();
+    return ret;
 }
-#endif
-#endif // NO_OPENCL
 
+///just realised a much faster version of this
 void post_render(const ImDrawList* parent_list, const ImDrawCmd* cmd)
 {
     render_window* win = (render_window*)cmd->UserCallbackData;
 
-    assert(win->clctx);
+    assert(win->frost);
 
-    #ifndef NO_OPENCL
-    #ifndef NO_OPENCL_SCREEN
-    blur_buffer(*win, win->clctx->cl_screen_tex);
-    #endif
-    #endif // NO_OPENCL
+    win->frost->render(*win, win->get_frostables());
+}
+
+void post_render_job(const ImDrawList* parent_list, const ImDrawCmd* cmd)
+{
+    render_window::frost_job* job = (render_window::frost_job*)cmd->UserCallbackData;
+
+    assert(job->win->frost);
+
+    job->win->frost->render(*job->win, job->frosty);
 }
 
 #ifdef USE_IMTUI
@@ -343,15 +623,306 @@ void imtui_backend::close()
 
 #endif // USE_IMTUI
 
+namespace
+{
+    ImVec4 intersect(const ImVec4& r1, const ImVec4& r2)
+    {
+        return {std::max(r1.x, r2.x), std::max(r1.y, r2.y), std::min(r1.z, r2.z), std::min(r1.w, r2.w)};
+    }
+
+    ImVec4 bound(const ImVec4& r1, const ImVec4& r2)
+    {
+        return {std::min(r1.x, r2.x), std::min(r1.y, r2.y), std::max(r1.z, r2.z), std::max(r1.w, r2.w)};
+    }
+
+    bool same(const ImVec2& v1, const ImVec2& v2)
+    {
+        return v1.x == v2.x && v1.y == v2.y;
+    }
+}
+
+bool damage_tracker::update(ImDrawData* data)
+{
+    std::vector<item> items;
+
+    bool has_callbacks = false;
+
+    for(int i=0; i < data->CmdListsCount; i++)
+    {
+        const ImDrawList* lst = data->CmdLists[i];
+
+        ///per list rather than per command, any change to a window damages all of it
+        ImU32 list_hash = ImHashData(lst->VtxBuffer.Data, lst->VtxBuffer.Size * sizeof(ImDrawVert));
+        list_hash = ImHashData(lst->IdxBuffer.Data, lst->IdxBuffer.Size * sizeof(ImDrawIdx), list_hash);
+
+        for(const ImDrawCmd& cmd : lst->CmdBuffer)
+        {
+            if(cmd.UserCallback != nullptr && cmd.UserCallback != ImDrawCallback_ResetRenderState)
+                has_callbacks = true;
+
+            ImU32 hash = ImHashData(&cmd.ClipRect, sizeof(cmd.ClipRect), list_hash);
+            hash = ImHashData(&cmd.TextureId, sizeof(cmd.TextureId), hash);
+            hash = ImHashData(&cmd.VtxOffset, sizeof(cmd.VtxOffset), hash);
+            hash = ImHashData(&cmd.IdxOffset, sizeof(cmd.IdxOffset), hash);
+            hash = ImHashData(&cmd.ElemCount, sizeof(cmd.ElemCount), hash);
+            hash = ImHashData(&cmd.UserCallback, sizeof(cmd.UserCallback), hash);
+
+            ///the job alternates between two slots frame to frame, so what it frosts is what matters, not where it lives
+            if(cmd.UserCallback == post_render_job)
+            {
+                const render_window::frost_job* job = (const render_window::frost_job*)cmd.UserCallbackData;
+
+                for(const frostable& f : job->frosty)
+                {
+                    hash = ImHashData(&f.pos, sizeof(f.pos), hash);
+                    hash = ImHashData(&f.dim, sizeof(f.dim), hash);
+                }
+            }
+            else
+            {
+                hash = ImHashData(&cmd.UserCallbackData, sizeof(cmd.UserCallbackData), hash);
+            }
+
+            items.push_back({hash, cmd.ClipRect});
+        }
+    }
+
+    ImVec4 screen = {data->DisplayPos.x, data->DisplayPos.y, data->DisplayPos.x + data->DisplaySize.x, data->DisplayPos.y + data->DisplaySize.y};
+
+    bool same_screen = same(data->DisplayPos, last_display_pos) && same(data->DisplaySize, last_display_size) && same(data->FramebufferScale, last_scale);
+
+    last_display_pos = data->DisplayPos;
+    last_display_size = data->DisplaySize;
+    last_scale = data->FramebufferScale;
+
+    if(!valid || !same_screen)
+    {
+        last = std::move(items);
+        valid = true;
+        full = true;
+        damage = screen;
+        return true;
+    }
+
+    bool identical = items.size() == last.size();
+
+    for(int i=0; i < (int)items.size() && identical; i++)
+    {
+        identical = items[i].hash == last[i].hash;
+    }
+
+    if(identical)
+        return false;
+
+    ///callbacks can read back what's already been drawn (eg frost), so a partial redraw isn't safe. Skipping a whole frame still is
+    if(has_callbacks)
+    {
+        last = std::move(items);
+        full = true;
+        damage = screen;
+        return true;
+    }
+
+    auto by_hash = [](const item& i1, const item& i2)
+    {
+        return i1.hash < i2.hash;
+    };
+
+    std::vector<item> sorted_next = items;
+    std::vector<item> sorted_last = last;
+
+    std::sort(sorted_next.begin(), sorted_next.end(), by_hash);
+    std::sort(sorted_last.begin(), sorted_last.end(), by_hash);
+
+    std::vector<item> changed;
+    std::set_symmetric_difference(sorted_next.begin(), sorted_next.end(), sorted_last.begin(), sorted_last.end(), std::back_inserter(changed), by_hash);
+
+    last = std::move(items);
+
+    ///the same commands in a different order, eg a window being brought to the front
+    if(changed.size() == 0)
+    {
+        full = true;
+        damage = screen;
+        return true;
+    }
+
+    damage = changed[0].clip;
+
+    for(const item& it : changed)
+    {
+        damage = bound(damage, it.clip);
+    }
+
+    damage = intersect(damage, screen);
+    full = false;
+
+    return true;
+}
+
+void damage_tracker::clear_and_clip(ImDrawData* data)
+{
+    if(full)
+    {
+        glClearColor(0,0,0,1);
+        glClear(GL_COLOR_BUFFER_BIT);
+        return;
+    }
+
+    int fb_height = (int)(data->DisplaySize.y * data->FramebufferScale.y);
+
+    int x0 = (int)((damage.x - data->DisplayPos.x) * data->FramebufferScale.x);
+    int y0 = (int)((damage.y - data->DisplayPos.y) * data->FramebufferScale.y);
+    int x1 = (int)ceilf((damage.z - data->DisplayPos.x) * data->FramebufferScale.x);
+    int y1 = (int)ceilf((damage.w - data->DisplayPos.y) * data->FramebufferScale.y);
+
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(x0, fb_height - y1, std::max(x1 - x0, 0), std::max(y1 - y0, 0));
+
+    glClearColor(0,0,0,1);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glDisable(GL_SCISSOR_TEST);
+
+    ///commands which end up with an empty clip rect are skipped by the renderer
+    for(int i=0; i < data->CmdListsCount; i++)
+    {
+        ImDrawList* lst = data->CmdLists[i];
+
+        for(ImDrawCmd& cmd : lst->CmdBuffer)
+        {
+            cmd.ClipRect = intersect(cmd.ClipRect, damage);
+        }
+    }
+}
+
+void damage_tracker::invalidate()
+{
+    valid = false;
+    last.clear();
+}
+
+namespace
+{
+    ///unlike ImVector's assignment, this keeps dst's allocation
+    template<typename T>
+    void copy_vector(ImVector<T>& dst, const ImVector<T>& src)
+    {
+        dst.resize(src.Size);
+
+        if(src.Size > 0)
+            memcpy(dst.Data, src.Data, sizeof(T) * src.Size);
+    }
+
+    ///CmdLists went from a raw array to an ImVector in imgui 1.89.8
+    template<typename T>
+    void set_cmd_lists(T& cmd_lists, std::vector<ImDrawList*>& ptrs)
+    {
+        if constexpr(std::is_pointer_v<T>)
+        {
+            cmd_lists = ptrs.data();
+        }
+        else
+        {
+            cmd_lists.resize(ptrs.size());
+
+            for(int i=0; i < (int)ptrs.size(); i++)
+                cmd_lists[i] = ptrs[i];
+        }
+    }
+}
+
+draw_data_snapshot::draw_data_snapshot()
+{
+
+}
+
+draw_data_snapshot::~draw_data_snapshot()
+{
+    for(ImDrawList* lst : lists)
+    {
+        IM_DELETE(lst);
+    }
+}
+
+void draw_data_snapshot::copy_from(ImDrawData* src)
+{
+    while((int)lists.size() < src->CmdListsCount)
+    {
+        lists.push_back(IM_NEW(ImDrawList)(nullptr));
+    }
+
+    list_ptrs.resize(src->CmdListsCount);
+
+    for(int i=0; i < src->CmdListsCount; i++)
+    {
+        const ImDrawList* from = src->CmdLists[i];
+        ImDrawList* to = lists[i];
+
+        copy_vector(to->CmdBuffer, from->CmdBuffer);
+        copy_vector(to->IdxBuffer, from->IdxBuffer);
+        copy_vector(to->VtxBuffer, from->VtxBuffer);
+        to->Flags = from->Flags;
+
+        list_ptrs[i] = to;
+    }
+
+    set_cmd_lists(data.CmdLists, list_ptrs);
+
+    data.Valid = src->Valid;
+    data.CmdListsCount = src->CmdListsCount;
+    data.TotalIdxCount = src->TotalIdxCount;
+    data.TotalVtxCount = src->TotalVtxCount;
+    data.DisplayPos = src->DisplayPos;
+    data.DisplaySize = src->DisplaySize;
+    data.FramebufferScale = src->FramebufferScale;
+}
+
 #ifndef NO_OPENCL
 opencl_context::opencl_context() : ctx(),
 #ifndef NO_OPENCL_SCREEN
-    cl_screen_tex(ctx), cl_image(ctx),
+    cl_image(ctx), frost_rects(ctx),
 #endif
     cqueue(ctx)
 {
 
 }
+
+#ifndef NO_OPENCL_SCREEN
+void opencl_context::alloc_frost_chain(vec2i screen_dim)
+{
+    frost_down.clear();
+    frost_up.clear();
+
+    vec2i dim = screen_dim;
+
+    for(int i=0; i < frost_levels; i++)
+    {
+        dim = max(dim / 2, (vec2i){1, 1});
+
+        cl::image& down = frost_down.emplace_back(ctx);
+        down.alloc(dim, cl_image_format{CL_RGBA, CL_HALF_FLOAT});
+
+        if(i == frost_levels - 1)
+            break;
+
+        cl::image& up = frost_up.emplace_back(ctx);
+        up.alloc(dim, cl_image_format{CL_RGBA, CL_HALF_FLOAT});
+    }
+}
+
+cl::gl_rendertexture& opencl_context::get_screen_tex()
+{
+    assert(cl_screen_index >= 0 && cl_screen_index < (int)cl_screen_texs.size());
+
+    return cl_screen_texs[cl_screen_index];
+}
+
+bool opencl_context::has_screen_tex()
+{
+    return cl_screen_texs.size() > 0;
+}
+#endif
 #endif // NO_OPENCL
 
 render_window::render_window(render_settings sett, generic_backend* _backend)
@@ -370,6 +941,7 @@ render_window::render_window(render_settings sett, generic_backend* _backend)
     #endif // __EMSCRIPTEN__
 
     settings = sett;
+    frost = std::make_unique<frost_renderer>();
 
     if(sett.opencl && backend->get_opencl_context())
     {
@@ -409,7 +981,13 @@ render_window::render_window(render_settings sett, const std::string& window_tit
         backend = new imtui_backend(sett, window_title);
     #endif // USE_IMTUI
 
+    #ifdef USE_HEADLESS
+    if(type == backend_type::HEADLESS)
+        backend = new headless_backend(sett);
+    #endif // USE_HEADLESS
+
     settings = sett;
+    frost = std::make_unique<frost_renderer>();
 
     if(sett.opencl && backend->get_opencl_context())
     {
@@ -434,6 +1012,10 @@ render_window::~render_window()
 {
     if(backend)
     {
+        ///frost's gl objects have to go before the backend takes the context down with it
+        backend->make_context_current_for_teardown();
+        frost.reset();
+
         delete backend;
         backend = nullptr;
     }
@@ -452,6 +1034,153 @@ render_settings render_window::get_render_settings()
     return sett;
 }
 
+void render_window::set_frost_backend(frost_backend::type type)
+{
+    frost->set_backend(type);
+}
+
+frost_backend::type render_window::get_frost_backend()
+{
+    return frost->get_backend();
+}
+
+void render_window::poll_paced()
+{
+    ///blocking or spinning would hang the page. The main loop runs off requestAnimationFrame, which does the pacing
+    #ifdef __EMSCRIPTEN__
+    invalidated = false;
+    backend->poll(0);
+    return;
+    #endif // __EMSCRIPTEN__
+
+    using clk = std::chrono::steady_clock;
+
+    clk::time_point now = clk::now();
+
+    #ifndef NO_OPENCL
+    pending_work.erase(std::remove_if(pending_work.begin(), pending_work.end(), [](cl::event& evt){return evt.is_finished();}), pending_work.end());
+    #endif // NO_OPENCL
+
+    bool active = invalidated.exchange(false) || settle_frames > 0 || now < animate_until || ImGui::GetIO().WantTextInput;
+
+    #ifndef NO_OPENCL
+    active = active || pending_work.size() > 0;
+    #endif // NO_OPENCL
+
+    if(settle_frames > 0)
+        settle_frames--;
+
+    ///os sleeps overshoot, so the last part of the frame is spent yielding instead
+    constexpr double spin_s = 0.001;
+    ///imgui needs a few frames after input before hover and click state settles
+    constexpr int frames_after_event = 3;
+
+    double timeout_s = -1;
+
+    if(active && !backend->is_minimised())
+    {
+        timeout_s = 0;
+
+        if(target_fps > 0)
+        {
+            double elapsed = std::chrono::duration<double>(now - last_frame).count();
+
+            timeout_s = std::max(1/target_fps - elapsed, 0.);
+        }
+    }
+
+    if(timeout_s < 0)
+    {
+        backend->wait_events(-1);
+
+        settle_frames = frames_after_event;
+    }
+    else if(timeout_s > 0)
+    {
+        clk::time_point deadline = now + std::chrono::duration_cast<clk::duration>(std::chrono::duration<double>(timeout_s));
+
+        double wait_s = timeout_s - spin_s;
+
+        if(wait_s > 0)
+        {
+            backend->wait_events(wait_s);
+
+            double waited = std::chrono::duration<double>(clk::now() - now).count();
+
+            ///woken up early, so something happened and the frame should go out now
+            if(waited < wait_s - spin_s / 2)
+            {
+                settle_frames = frames_after_event;
+                deadline = clk::now();
+            }
+        }
+
+        while(clk::now() < deadline)
+            std::this_thread::yield();
+    }
+
+    last_frame = clk::now();
+
+    backend->poll(0);
+}
+
+void render_window::set_target_fps(double fps)
+{
+    target_fps = fps;
+}
+
+double render_window::get_target_fps()
+{
+    return target_fps;
+}
+
+void render_window::request_animation(double duration_s)
+{
+    auto until = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(duration_s));
+
+    animate_until = std::max(animate_until, until);
+
+    if(duration_s <= 0)
+        invalidated = true;
+}
+
+void render_window::invalidate()
+{
+    invalidated = true;
+
+    backend->wake();
+}
+
+#ifndef NO_OPENCL
+void render_window::add_pending_work(const cl::event& evt)
+{
+    pending_work.push_back(evt);
+}
+#endif // NO_OPENCL
+
+void render_window::display()
+{
+    #ifndef USE_IMTUI
+    ///frost runs after the background, but before any windows. Imgui's own render state has to be set back up after it
+    ///the rects are captured once here, which also means a render thread never has to look at imgui's windows
+    frost_job& job = frost_jobs[next_frost_job];
+    job.win = this;
+    job.frosty = get_frostables();
+
+    if(job.frosty.size() > 0)
+    {
+        next_frost_job = (next_frost_job + 1) % frost_jobs.size();
+
+        ImDrawList* lst = ImGui::GetBackgroundDrawList();
+
+        lst->AddCallback(post_render_job, &job);
+        lst->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+    }
+    #endif // USE_IMTUI
+
+    return backend->display();
+}
+
 void render_window::set_srgb(bool enabled)
 {
     if(enabled == settings.is_srgb)
@@ -467,40 +1196,39 @@ void render_window::set_srgb(bool enabled)
 #ifndef USE_IMTUI
 std::vector<frostable> render_window::get_frostables()
 {
-    ImGuiContext& g = *GImGui;
+    std::vector<frost_rect_f> window_rects;
+
+    ImVec2 offset = {0, 0};
 
-    std::vector<frostable> frosts;
+    if(ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+        offset = ImGui::GetMainViewport()->Pos;
 
-    for(int i = 0; i != g.Windows.Size; i++)
+    for(ImGuiID id : frost_ids)
     {
-        ImGuiWindow* window = g.Windows[i];
-        if(window->Active && (window->Flags & (ImGuiWindowFlags_ChildWindow)) == 0)
-        {
-            std::string name = std::string(window->Name);
+        ImGuiWindow* window = ImGui::FindWindowByID(id);
 
-            auto it = frost_map.find(name);
+        if(window == nullptr || !window->Active || (window->Flags & ImGuiWindowFlags_ChildWindow) != 0)
+            continue;
 
-            if(it == frost_map.end() || it->second == false)
-                continue;
+        window_rects.push_back({{window->Pos.x - offset.x, window->Pos.y - offset.y}, window->Size});
+    }
 
-            auto pos = window->Pos;
-            ImVec2 dim = window->Size;
+    if(window_rects == cached_window_rects)
+        return cached_frostables;
 
-            if(ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
-            {
-                pos.x -= ImGui::GetMainViewport()->Pos.x;
-                pos.y -= ImGui::GetMainViewport()->Pos.y;
-            }
+    cached_window_rects = window_rects;
+    cached_frostables.clear();
 
-            frostable f;
-            f.pos = {pos.x, pos.y};
-            f.dim = {dim.x, dim.y};
+    for(const frost_rect_f& r : make_disjoint(window_rects))
+    {
+        frostable f;
+        f.pos = {r.pos.x, r.pos.y};
+        f.dim = {r.size.x, r.size.y};
 
-            frosts.push_back(f);
-        }
+        cached_frostables.push_back(f);
     }
 
-    return frosts;
+    return cached_frostables;
 }
 #endif // USE_IMTUI
 
@@ -569,6 +1297,18 @@ void render_window::render(const std::vector<vertex>& vertices, texture* tex)
     idl->PopTextureID();
 }
 
+void render_window::render(const std::vector<vertex>& vertices, const atlas_region& region)
+{
+    std::vector<vertex> remapped = vertices;
+
+    for(vertex& v : remapped)
+    {
+        v.uv = region.to_page_uv(v.uv);
+    }
+
+    render(remapped, region.tex);
+}
+
 void render_window::render_texture(unsigned int handle, vec2f p_min, vec2f p_max)
 {
     ImDrawList* lst = ImGui::GetBackgroundDrawList();
@@ -578,10 +1318,32 @@ void render_window::render_texture(unsigned int handle, vec2f p_min, vec2f p_max
 
 void gui::frost(const std::string& window_name)
 {
-    frost_map[window_name] = true;
+    ImGuiID id = ImHashStr(window_name.c_str());
+
+    auto it = std::lower_bound(frost_ids.begin(), frost_ids.end(), id);
+
+    if(it != frost_ids.end() && *it == id)
+        return;
+
+    frost_ids.insert(it, id);
+}
+
+void gui::unfrost(const std::string& window_name)
+{
+    ImGuiID id = ImHashStr(window_name.c_str());
+
+    auto it = std::lower_bound(frost_ids.begin(), frost_ids.end(), id);
+
+    if(it != frost_ids.end() && *it == id)
+        frost_ids.erase(it);
 }
 
 void gui::current::frost()
 {
     return gui::frost(std::string(ImGui::GetCurrentWindow()->Name));
 }
+
+void gui::current::unfrost()
+{
+    return gui::unfrost(std::string(ImGui::GetCurrentWindow()->Name));
+}
@@ -10,16 +10,59 @@
 
 #include <vec/vec.hpp>
 #include <imgui/imgui.h>
+#include <memory>
+#include <functional>
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <networking/serialisable_fwd.hpp>
 #include "clock.hpp"
 
 struct texture;
 struct vertex;
+struct atlas_region;
+struct frost_renderer;
 
 struct dropped_file
 {
     std::string name;
     std::string data;
+    ///the full path on disk. Empty on emscripten
+    std::string path;
+    uint64_t size = 0;
+    ///bigger than render_settings::max_dropped_file_size, so data is left empty. It can still be streamed or mapped from path
+    bool too_large = false;
+};
+
+struct dropped_file_progress
+{
+    std::string name;
+    uint64_t bytes_read = 0;
+    uint64_t size = 0;
+};
+
+struct dropped_file_loader_state;
+
+///reads dropped files in binary on a worker thread, so that dropping something large doesn't stall the ui
+struct dropped_file_loader
+{
+    uint64_t max_size = 0;
+    ///called on the worker whenever a file finishes, eg to wake up a sleeping poll
+    std::function<void()> on_finished;
+
+    dropped_file_loader();
+    ~dropped_file_loader();
+
+    ///thread safe
+    void add(const std::string& path, const std::string& name);
+    ///finished files, in the order they were dropped
+    std::vector<dropped_file> take_finished();
+    ///files which are queued or being read
+    std::vector<dropped_file_progress> get_progress();
+
+private:
+    std::unique_ptr<dropped_file_loader_state> state;
 };
 
 struct render_settings : serialisable, free_function
@@ -34,6 +77,16 @@ struct render_settings : serialisable, free_function
     bool vsync = false;
     bool no_decoration = false;
     bool is_taskbar_hidden = false;
+    ///skips presenting frames whose draw data is unchanged, and only redraws the area of the ones that changed
+    bool damage_tracking = false;
+    ///how many offscreen render targets are cycled through, letting the cpu build frames while the gpu is still busy with earlier ones
+    int frames_in_flight = 1;
+    ///renders and presents frames on a dedicated gl thread, while the calling thread moves on to the next frame. glfw only, and disables viewports
+    ///a frame is still being drawn after display() returns, so textures it uses must stay alive until the next display() has returned
+    ///can't be combined with opencl screen sharing
+    bool render_thread = false;
+    ///dropped files bigger than this are handed out without their contents
+    uint64_t max_dropped_file_size = 512 * 1024 * 1024;
 };
 
 namespace backend_type
@@ -42,6 +95,20 @@ namespace backend_type
     {
         GLFW,
         IMTUI,
+        ///needs USE_HEADLESS
+        HEADLESS,
+    };
+}
+
+namespace frost_backend
+{
+    enum type
+    {
+        AUTO,
+        NONE,
+        OPENCL,
+        GL,
+        CPU,
     };
 }
 
@@ -52,6 +119,60 @@ struct frostable
 };
 
 
+///hashes imgui's draw data per draw command, so that a backend can skip identical frames, and only redraw the area that changed
+///textures are compared by id, so anything that changes a texture's contents behind imgui's back needs to call invalidate
+struct damage_tracker
+{
+    bool enabled = false;
+
+    ///call after ImGui::Render. Returns false if the frame is identical to the last one, and doesn't need to be rendered or presented
+    bool update(ImDrawData* data);
+
+    ///clears only the damaged area of the bound framebuffer, and clips the draw commands to it
+    void clear_and_clip(ImDrawData* data);
+
+    ///forces the next frame to be redrawn in full
+    void invalidate();
+
+private:
+    struct item
+    {
+        ImU32 hash = 0;
+        ImVec4 clip;
+    };
+
+    std::vector<item> last;
+    bool valid = false;
+    bool full = true;
+
+    ///in imgui display coordinates
+    ImVec4 damage;
+
+    ImVec2 last_display_pos;
+    ImVec2 last_display_size;
+    ImVec2 last_scale;
+};
+
+///a deep copy of imgui's draw data, which can be rendered after imgui has moved on to the next frame
+///the draw lists and their buffers are kept between copies, so a steady ui stops allocating
+struct draw_data_snapshot
+{
+    ImDrawData data;
+
+    draw_data_snapshot();
+    ~draw_data_snapshot();
+
+    draw_data_snapshot(const draw_data_snapshot&) = delete;
+    draw_data_snapshot& operator=(const draw_data_snapshot&) = delete;
+
+    void copy_from(ImDrawData* src);
+
+private:
+    std::vector<ImDrawList*> lists;
+    ///the first CmdListsCount of lists
+    std::vector<ImDrawList*> list_ptrs;
+};
+
 #ifdef NO_OPENCL
 struct opencl_context
 {
@@ -62,19 +183,38 @@ struct opencl_context
 {
     cl::context ctx;
     #ifndef NO_OPENCL_SCREEN
-    cl::gl_rendertexture cl_screen_tex;
+    ///one per render target, in the same order as the backend's render_target_ring
+    std::vector<cl::gl_rendertexture> cl_screen_texs;
+    int cl_screen_index = 0;
     cl::image cl_image;
+
+    ///frost_down[0] is half the screen size, and each level after it is half again. frost_up mirrors every level but the smallest
+    std::vector<cl::image> frost_down;
+    std::vector<cl::image> frost_up;
+    cl::buffer frost_rects;
     #endif
     cl::command_queue cqueue;
 
     opencl_context();
+
+    #ifndef NO_OPENCL_SCREEN
+    static constexpr int frost_levels = 4;
+
+    void alloc_frost_chain(vec2i screen_dim);
+
+    ///the render target the current frame is being drawn into
+    cl::gl_rendertexture& get_screen_tex();
+    bool has_screen_tex();
+    #endif
 };
 #endif // NO_OPENCL
 
 namespace emscripten_drag_drop
 {
-    void init();
+    ///files bigger than max_size are handed out without their contents
+    void init(uint64_t max_size = 512 * 1024 * 1024);
     std::vector<dropped_file> get_dropped_files();
+    std::vector<dropped_file_progress> get_progress();
 }
 
 struct generic_backend
@@ -82,9 +222,16 @@ struct generic_backend
     //virtual void set_srgb(bool enabled){}
     virtual bool is_vsync(){return false;}
     virtual void set_vsync(bool enabled){(void)enabled;}
+    virtual void set_damage_tracking(bool enabled){(void)enabled;}
+    virtual void invalidate_damage(){}
     virtual void poll(double maximum_sleep_s = 0){(void)maximum_sleep_s;}
     virtual void poll_events_only(double maximum_sleep_s = 0){(void)maximum_sleep_s;}
     virtual void poll_issue_new_frame_only(){}
+    ///waits until an event arrives or the timeout passes, without processing anything. A negative timeout waits indefinitely
+    virtual void wait_events(double timeout_s){(void)timeout_s;}
+    ///thread safe, interrupts wait_events
+    virtual void wake(){}
+    virtual bool is_minimised(){return false;}
     virtual void display_bind_and_clear(){}
     virtual void display_render(){}
     virtual void display(){display_bind_and_clear(); display_render();}
@@ -107,6 +254,12 @@ struct generic_backend
     virtual bool has_dropped_file(){return false;}
     virtual dropped_file get_next_dropped_file(){return dropped_file();}
     virtual void pop_dropped_file(){}
+    virtual std::vector<dropped_file_progress> get_dropped_file_progress(){return {};}
+
+    ///true if frames are rendered on another thread, so draw callbacks can't touch imgui state
+    virtual bool is_render_threaded(){return false;}
+    ///stops any render thread, and makes the window's own context current on this thread, so that gl objects owned by the window can be deleted
+    virtual void make_context_current_for_teardown(){}
 
     virtual ~generic_backend(){}
 };
@@ -157,37 +310,96 @@ struct render_window
 
     void set_srgb(bool enabled);
     void set_vsync(bool enabled){return backend->set_vsync(enabled);}
+    void set_damage_tracking(bool enabled){settings.damage_tracking = enabled; return backend->set_damage_tracking(enabled);}
+    ///with damage tracking, this must be called when a texture that imgui draws has its contents changed
+    void invalidate_damage(){return backend->invalidate_damage();}
 
     void poll(double maximum_sleep_s = 0){return backend->poll(maximum_sleep_s);}
     void poll_events_only(double maximum_sleep_s = 0) {return backend->poll_events_only(maximum_sleep_s);}
     void poll_issue_new_frame_only() {return backend->poll_issue_new_frame_only();}
 
+    ///a poll which paces frames itself. While nothing is animating it sleeps until input arrives or invalidate is called
+    ///otherwise it targets get_target_fps. Minimised windows always sleep until an event
+    ///under emscripten this is just poll(0), and the browser's main loop does the pacing
+    void poll_paced();
+    ///0 means unlimited
+    void set_target_fps(double fps);
+    double get_target_fps();
+    ///keeps frames coming for duration_s, or just the next frame for 0
+    void request_animation(double duration_s = 0);
+    ///thread safe. Wakes up a sleeping poll_paced, and makes sure the next frame is drawn
+    void invalidate();
+    #ifndef NO_OPENCL
+    ///keeps frames coming until evt completes, so that the ui can show its result
+    void add_pending_work(const cl::event& evt);
+    #endif // NO_OPENCL
+
     std::vector<frostable> get_frostables();
 
+    ///defaults to AUTO, which picks the fastest backend that works on this machine
+    void set_frost_backend(frost_backend::type type);
+    frost_backend::type get_frost_backend();
+
     void display_last_frame(){return backend->display_last_frame();}
-    void display(){return backend->display();}
+    void display();
     bool should_close(){return backend->should_close();}
     void close(){return backend->close();}
     void resize(vec2i dim){return backend->resize(dim);}
 
     void render(const std::vector<vertex>& vertices, texture* tex = nullptr);
+    ///uvs are relative to the atlas entry
+    void render(const std::vector<vertex>& vertices, const atlas_region& region);
     void render_texture(unsigned int handle, vec2f p_min, vec2f p_max);
 
     bool has_dropped_file(){return backend->has_dropped_file();}
     dropped_file get_next_dropped_file(){return backend->get_next_dropped_file();}
     void pop_dropped_file(){return backend->pop_dropped_file();}
+    ///dropped files which are still being read
+    std::vector<dropped_file_progress> get_dropped_file_progress(){return backend->get_dropped_file_progress();}
+
+    std::unique_ptr<frost_renderer> frost;
 
 private:
     render_settings settings;
+
+    double target_fps = 60;
+    std::atomic_bool invalidated{true};
+    std::chrono::steady_clock::time_point animate_until;
+    std::chrono::steady_clock::time_point last_frame;
+    int settle_frames = 0;
+
+    #ifndef NO_OPENCL
+    std::vector<cl::event> pending_work;
+    #endif // NO_OPENCL
+
+    ///frostables captured once per frame by display(). With a render thread, one frame can be rendering while the next is built
+    struct frost_job
+    {
+        render_window* win = nullptr;
+        std::vector<frostable> frosty;
+    };
+
+    std::array<frost_job, 2> frost_jobs;
+    int next_frost_job = 0;
+
+    friend void post_render_job(const ImDrawList* parent_list, const ImDrawCmd* cmd);
+    friend struct damage_tracker;
 };
 
+///imgui draw callback, with the render_window as its user data. Blurs the frosted windows of the bound framebuffer
+void post_render(const ImDrawList* parent_list, const ImDrawCmd* cmd);
+///the same, with the frostables already captured. The user data is a frost_job
+void post_render_job(const ImDrawList* parent_list, const ImDrawCmd* cmd);
+
 namespace gui
 {
     void frost(const std::string& window_name);
+    void unfrost(const std::string& window_name);
 
     namespace current
     {
         void frost();
+        void unfrost();
     }
 }
 
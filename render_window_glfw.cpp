@@ -11,6 +11,11 @@
 #include <GLFW/glfw3.h>
 #include <map>
 #include <iostream>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <array>
 #include <toolkit/fs_helpers.hpp>
 
 
@@ -25,7 +30,8 @@
 
 namespace
 {
-    thread_local std::vector<dropped_file> dropped_files;
+    ///paths from glfw's drop callback, which are handed to the backend's loader on the next poll
+    thread_local std::vector<std::string> dropped_paths;
 }
 
 void glfw_error_callback(int error, const char* description)
@@ -38,6 +44,54 @@ struct glfw_user_data
     int max_frames = 0;
 };
 
+///everything the render thread needs to know about a frame, captured on the calling thread
+struct glfw_threaded_frame
+{
+    ///nullptr re-presents the last frame
+    draw_data_snapshot* snapshot = nullptr;
+    vec2i dim;
+    bool linear_colour = false;
+    bool vsync = false;
+    int refresh = 60;
+    bool damage_enabled = false;
+    bool damage_invalidate = false;
+    bool screen_dirty = false;
+    ///makes the render context wait for anything the calling thread uploaded through the shared context
+    GLsync upload_fence = nullptr;
+};
+
+struct glfw_render_thread
+{
+    ///invisible, and shares objects with the main window. Current on the calling thread so that textures can still be made there
+    GLFWwindow* upload_window = nullptr;
+
+    std::thread thread;
+    std::mutex lock;
+    std::condition_variable cv;
+
+    glfw_threaded_frame next;
+    bool has_next = false;
+    ///set from submission until the render thread has swapped
+    bool busy = false;
+    bool quit = false;
+
+    ///one can be copied into while the other renders
+    std::array<draw_data_snapshot, 2> snapshots;
+    int next_snapshot = 0;
+
+    ///calling thread only, folded into the next frame
+    bool damage_enabled = false;
+    bool pending_damage_invalidate = false;
+    bool pending_screen_dirty = true;
+
+    ///set before the first frame is submitted, and never changed
+    std::thread::id id;
+
+    ///render thread only
+    vec2i rendering_dim;
+    int applied_vsync = -1;
+};
+
 #ifndef __EMSCRIPTEN__
 void maximise_callback(GLFWwindow* window, int maximized)
 {
@@ -59,44 +113,11 @@ void drop_callback(GLFWwindow* window, int count, const char** paths)
 {
     for(int i=0; i < count; i++)
     {
-        std::string name = std::string(paths[i]);
-        std::string data = file::read(name, file::mode::TEXT);
-
-        dropped_file fle;
-        fle.name = std::filesystem::path(name).filename().string();
-        fle.data = data;
-
-        dropped_files.push_back(fle);
+        dropped_paths.push_back(std::string(paths[i]));
     }
 }
 #endif // __EMSCRIPTEN__
 
-void make_fbo(unsigned int* fboptr, unsigned int* tex, vec2i dim, bool is_srgb)
-{
-    int wx = dim.x();
-    int wy = dim.y();
-
-    glGenFramebuffers(1, fboptr);
-    glBindFramebuffer(GL_FRAMEBUFFER, *fboptr);
-
-    glGenTextures(1, tex);
-    glBindTexture(GL_TEXTURE_2D, *tex);
-
-    #ifndef __EMSCRIPTEN__
-    if(!is_srgb)
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, wx, wy, 0, GL_RGBA, GL_FLOAT, NULL);
-    else
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8, wx, wy, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    #else
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, wx, wy, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    #endif
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *tex, 0);
-}
-
 glfw_render_context::glfw_render_context(const render_settings& lsett, const std::string& window_title)
 {
     render_settings sett = lsett;
@@ -163,7 +184,8 @@ glfw_render_context::glfw_render_context(const render_settings& lsett, const std
 
     io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
 
-    if(sett.viewports)
+    ///platform windows are created and rendered from imgui's state, which the render thread can't touch
+    if(sett.viewports && !sett.render_thread)
         io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
 
     ImGuiStyle& style = ImGui::GetStyle();
@@ -212,53 +234,121 @@ glfw_backend::glfw_backend(const render_settings& sett, const std::string& windo
 
     set_vsync(sett.vsync);
 
+    damage.enabled = sett.damage_tracking;
+    frames_in_flight = sett.frames_in_flight;
+
+    drop_loader.max_size = sett.max_dropped_file_size;
+    drop_loader.on_finished = [this](){wake();};
+
+    ///the shared screen textures are swapped out on the render thread, while the calling thread hands them to opencl
+    #ifndef NO_OPENCL
+    #ifndef NO_OPENCL_SCREEN
+    if(sett.opencl && sett.render_thread)
+        throw std::runtime_error("render_thread can't be combined with opencl screen sharing");
+    #endif
+    #endif // NO_OPENCL
+
     #ifndef NO_OPENCL
     if(sett.opencl)
         clctx = new opencl_context();
     #endif // NO_OPENCL
 
+    #ifndef __EMSCRIPTEN__
+    if(sett.render_thread)
+    {
+        threaded = std::make_unique<glfw_render_thread>();
+        threaded->damage_enabled = damage.enabled;
+
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        threaded->upload_window = glfwCreateWindow(1, 1, "", nullptr, ctx.window);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+        if(threaded->upload_window == nullptr)
+            throw std::runtime_error("Could not create the render thread's upload context");
+
+        ///a context can only be current on one thread at a time
+        glfwMakeContextCurrent(threaded->upload_window);
+
+        ImGuiContext* imgui_ctx = ImGui::GetCurrentContext();
+
+        threaded->thread = std::thread([this, imgui_ctx](){render_thread_main(imgui_ctx);});
+        threaded->id = threaded->thread.get_id();
+    }
+    #endif // __EMSCRIPTEN__
+
     #ifdef __EMSCRIPTEN__
-    emscripten_drag_drop::init();
+    emscripten_drag_drop::init(sett.max_dropped_file_size);
     #endif // __EMSCRIPTEN__
 }
 
-void glfw_backend::init_screen(vec2i dim)
+void glfw_backend::bind_render_target()
 {
-    if(dim.x() < 32)
-        dim.x() = 32;
-
-    if(dim.y() < 32)
-        dim.y() = 32;
+    frame_target& target = targets.acquire();
 
-    if(ctx.screens_init)
-    {
-        glDeleteTextures(1, &ctx.screen_tex);
-        glDeleteTextures(1, &ctx.screen_tex_srgb);
+    #ifndef NO_OPENCL
+    #ifndef NO_OPENCL_SCREEN
+    if(clctx)
+        clctx->cl_screen_index = targets.get_index();
+    #endif
+    #endif // NO_OPENCL
 
-        glDeleteFramebuffers(1, &ctx.fbo);
-        glDeleteFramebuffers(1, &ctx.fbo_srgb);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.fbo);
+}
 
-        ctx.screen_tex = 0;
-        ctx.screen_tex_srgb = 0;
-        ctx.fbo = 0;
-        ctx.fbo_srgb = 0;
+void glfw_backend::create_screen(vec2i dim)
+{
+    ///the shared images have to go before the textures they wrap
+    #ifndef NO_OPENCL
+    #ifndef NO_OPENCL_SCREEN
+    if(clctx)
+    {
+        clctx->cl_screen_texs.clear();
+        clctx->cl_screen_index = 0;
     }
+    #endif
+    #endif // NO_OPENCL
 
-    make_fbo(&ctx.fbo, &ctx.screen_tex, dim, false);
-    make_fbo(&ctx.fbo_srgb, &ctx.screen_tex_srgb, dim, true);
-    ctx.screens_init = true;
+    targets.create(frames_in_flight, dim);
+
+    damage.invalidate();
+    ///the default framebuffer may have changed along with the window, eg it moved to a different monitor
+    presenter.invalidate();
 
     #ifndef NO_OPENCL
     #ifndef NO_OPENCL_SCREEN
     if(clctx)
     {
-        clctx->cl_screen_tex.create_from_texture(ctx.screen_tex);
+        for(int i=0; i < targets.size(); i++)
+        {
+            clctx->cl_screen_texs.emplace_back(clctx->ctx).create_from_texture(targets.get_nth(i).tex);
+        }
+
         clctx->cl_image.alloc(dim, cl_image_format{CL_RGBA, CL_FLOAT});
+        clctx->alloc_frost_chain(dim);
     }
     #endif
     #endif // NO_OPENCL
 }
 
+void glfw_backend::init_screen(vec2i dim)
+{
+    if(dim.x() < 32)
+        dim.x() = 32;
+
+    if(dim.y() < 32)
+        dim.y() = 32;
+
+    ///the render thread recreates its targets at the size of the next frame
+    if(threaded)
+    {
+        threaded->pending_screen_dirty = true;
+        return;
+    }
+
+    create_screen(dim);
+}
+
+
 void glfw_backend::set_is_hidden(bool is_hidden)
 {
     if(is_hidden)
@@ -269,6 +359,15 @@ void glfw_backend::set_is_hidden(bool is_hidden)
 
 glfw_backend::~glfw_backend()
 {
+    if(threaded)
+    {
+        make_context_current_for_teardown();
+
+        glfwDestroyWindow(threaded->upload_window);
+
+        threaded.reset();
+    }
+
     if(clctx)
     {
         delete clctx;
@@ -280,6 +379,10 @@ vec2i glfw_backend::get_window_size()
 {
     assert(ctx.window);
 
+    ///glfw's window functions are main thread only, so draw callbacks on the render thread get the size of the frame being rendered
+    if(threaded && std::this_thread::get_id() == threaded->id)
+        return threaded->rendering_dim;
+
     int display_w = 0;
     int display_h = 0;
 
@@ -333,6 +436,13 @@ void glfw_backend::set_vsync(bool enabled)
     if(enabled == is_vsync_enabled)
         return;
 
+    ///applied by the render thread, which owns the window's context
+    if(threaded)
+    {
+        is_vsync_enabled = enabled;
+        return;
+    }
+
     if(enabled)
         glfwSwapInterval(1);
     else
@@ -341,6 +451,46 @@ void glfw_backend::set_vsync(bool enabled)
     is_vsync_enabled = enabled;
 }
 
+void glfw_backend::set_damage_tracking(bool enabled)
+{
+    if(threaded)
+    {
+        threaded->damage_enabled = enabled;
+        threaded->pending_damage_invalidate = true;
+        return;
+    }
+
+    damage.enabled = enabled;
+    damage.invalidate();
+}
+
+void glfw_backend::invalidate_damage()
+{
+    if(threaded)
+    {
+        threaded->pending_damage_invalidate = true;
+        return;
+    }
+
+    damage.invalidate();
+}
+
+///stands in for the swap that would have blocked, so that an unchanged ui doesn't spin, whether or not vsync is on
+void glfw_backend::skip_present()
+{
+    ///the browser paces frames itself
+    #ifdef __EMSCRIPTEN__
+    return;
+    #endif // __EMSCRIPTEN__
+
+    GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+    const GLFWvidmode* mode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+
+    int refresh = (mode && mode->refreshRate > 0) ? mode->refreshRate : 60;
+
+    std::this_thread::sleep_for(std::chrono::microseconds(1000000 / refresh));
+}
+
 void glfw_backend::poll_events_only(double maximum_sleep_s)
 {
     assert(ctx.window);
@@ -385,18 +535,38 @@ void glfw_backend::poll_events_only(double maximum_sleep_s)
     #endif // __EMSCRIPTEN__
 
     #ifndef __EMSCRIPTEN__
-    if(dropped_files.size() > 0)
+    for(const std::string& path : dropped_paths)
     {
-        for(auto& i : dropped_files)
-        {
-            dropped.push_back(i);
-        }
+        drop_loader.add(path, std::filesystem::path(path).filename().string());
+    }
+
+    dropped_paths.clear();
 
-        dropped_files.clear();
+    for(dropped_file& fle : drop_loader.take_finished())
+    {
+        dropped.push_back(std::move(fle));
     }
     #endif // __EMSCRIPTEN__
 }
 
+void glfw_backend::wait_events(double timeout_s)
+{
+    if(timeout_s < 0)
+        glfwWaitEvents();
+    else
+        glfwWaitEventsTimeout(timeout_s);
+}
+
+void glfw_backend::wake()
+{
+    glfwPostEmptyEvent();
+}
+
+bool glfw_backend::is_minimised()
+{
+    return glfwGetWindowAttrib(ctx.window, GLFW_ICONIFIED) != 0;
+}
+
 void glfw_backend::poll_issue_new_frame_only()
 {
     ImGui::NewFrame();
@@ -425,13 +595,22 @@ void glfw_backend::display_bind_and_clear()
         user_data->max_frames--;
     }
 
+    ///the render thread does all of this once the frame is submitted
+    if(threaded)
+        return;
+
     vec2i dim = get_window_size();
 
     glfwMakeContextCurrent(ctx.window);
 
     glViewport(0, 0, dim.x(), dim.y());
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, ctx.fbo);
+    bind_render_target();
+
+    ///with damage tracking the fbo holds the last frame, and only the damaged area gets cleared once it's known
+    if(damage.enabled)
+        return;
+
     glClearColor(0,0,0,1);
     glClear(GL_COLOR_BUFFER_BIT);
 }
@@ -441,6 +620,31 @@ void glfw_backend::display_render()
     vec2i dim = get_window_size();
 
     ImGui::Render();
+
+    if(threaded)
+    {
+        submit_threaded(ImGui::GetDrawData());
+        return;
+    }
+
+    bool tracking = damage.enabled && (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable) == 0;
+
+    if(tracking)
+    {
+        if(!damage.update(ImGui::GetDrawData()))
+        {
+            skip_present();
+            return;
+        }
+
+        damage.clear_and_clip(ImGui::GetDrawData());
+    }
+    else if(damage.enabled)
+    {
+        glClearColor(0,0,0,1);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
     //glDrawBuffer(GL_BACK);
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
@@ -452,29 +656,11 @@ void glfw_backend::display_render()
         glfwMakeContextCurrent(backup_current_context);
     }
 
-    if(ImGui::GetCurrentContext()->IsLinearColor)
-    {
-        glEnable(GL_FRAMEBUFFER_SRGB);
-
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, ctx.fbo_srgb);
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, ctx.fbo);
-
-        glBlitFramebuffer(0, 0, dim.x(), dim.y(), 0, 0, dim.x(), dim.y(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    presenter.present(targets.get().fbo, targets.get().tex, dim, ImGui::GetCurrentContext()->IsLinearColor);
 
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, ctx.fbo_srgb);
-
-        glBlitFramebuffer(0, 0, dim.x(), dim.y(), 0, 0, dim.x(), dim.y(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
-
-        glDisable(GL_FRAMEBUFFER_SRGB);
-    }
-    else
-    {
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, ctx.fbo);
-
-        glBlitFramebuffer(0, 0, dim.x(), dim.y(), 0, 0, dim.x(), dim.y(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
-    }
+    ///damage tracking redraws on top of the previous frame, so it always renders into the same target
+    if(!damage.enabled)
+        targets.release();
 
     glfwSwapBuffers(ctx.window);
 }
@@ -502,28 +688,24 @@ void glfw_backend::display_last_frame()
         throw std::runtime_error("Can't do this with viewports");
     }
 
-    vec2i dim = get_window_size();
-
-    glfwMakeContextCurrent(ctx.window);
-
-    if(ImGui::GetCurrentContext()->IsLinearColor)
+    if(threaded)
     {
-        glEnable(GL_FRAMEBUFFER_SRGB);
+        submit_threaded(nullptr);
+        return;
+    }
 
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, ctx.fbo_srgb);
+    ///the last frame is still on screen, there's nothing to redraw
+    if(damage.enabled)
+    {
+        skip_present();
+        return;
+    }
 
-        glBlitFramebuffer(0, 0, dim.x(), dim.y(), 0, 0, dim.x(), dim.y(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    vec2i dim = get_window_size();
 
-        glDisable(GL_FRAMEBUFFER_SRGB);
-    }
-    else
-    {
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, ctx.fbo);
+    glfwMakeContextCurrent(ctx.window);
 
-        glBlitFramebuffer(0, 0, dim.x(), dim.y(), 0, 0, dim.x(), dim.y(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
-    }
+    presenter.present(targets.last().fbo, targets.last().tex, dim, ImGui::GetCurrentContext()->IsLinearColor);
 
     glfwSwapBuffers(ctx.window);
 }
@@ -782,6 +964,181 @@ bool glfw_backend::is_focused()
     return glfwGetWindowAttrib(ctx.window, GLFW_FOCUSED);
 }
 
+bool glfw_backend::is_render_threaded()
+{
+    return threaded != nullptr;
+}
+
+void glfw_backend::make_context_current_for_teardown()
+{
+    ///the render thread holds the window's context until it exits
+    if(threaded && threaded->thread.joinable())
+    {
+        {
+            std::lock_guard guard(threaded->lock);
+            threaded->quit = true;
+        }
+
+        threaded->cv.notify_all();
+        threaded->thread.join();
+    }
+
+    glfwMakeContextCurrent(ctx.window);
+}
+
+void glfw_backend::submit_threaded(ImDrawData* data)
+{
+    glfw_render_thread& rt = *threaded;
+
+    glfw_threaded_frame frame;
+
+    ///the render thread only ever reads the other snapshot, so this one can be written before waiting on it
+    if(data)
+    {
+        frame.snapshot = &rt.snapshots[rt.next_snapshot];
+        frame.snapshot->copy_from(data);
+
+        rt.next_snapshot = (rt.next_snapshot + 1) % rt.snapshots.size();
+    }
+
+    GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+    const GLFWvidmode* mode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+
+    frame.dim = get_window_size();
+    frame.dim = max(frame.dim, (vec2i){32, 32});
+    frame.linear_colour = ImGui::GetCurrentContext()->IsLinearColor;
+    frame.vsync = is_vsync_enabled;
+    frame.refresh = (mode && mode->refreshRate > 0) ? mode->refreshRate : 60;
+    frame.damage_enabled = rt.damage_enabled;
+    frame.damage_invalidate = rt.pending_damage_invalidate;
+    frame.screen_dirty = rt.pending_screen_dirty;
+
+    frame.upload_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    {
+        std::unique_lock guard(rt.lock);
+
+        rt.cv.wait(guard, [&](){return !rt.busy;});
+
+        rt.next = frame;
+        rt.has_next = true;
+        rt.busy = true;
+    }
+
+    rt.cv.notify_all();
+
+    rt.pending_damage_invalidate = false;
+    rt.pending_screen_dirty = false;
+}
+
+void glfw_backend::render_thread_main(ImGuiContext* imgui_ctx)
+{
+    glfw_render_thread& rt = *threaded;
+
+    glfwMakeContextCurrent(ctx.window);
+    ImGui::SetCurrentContext(imgui_ctx);
+
+    while(1)
+    {
+        glfw_threaded_frame frame;
+
+        {
+            std::unique_lock guard(rt.lock);
+
+            rt.cv.wait(guard, [&](){return rt.has_next || rt.quit;});
+
+            if(!rt.has_next)
+                break;
+
+            frame = rt.next;
+            rt.has_next = false;
+        }
+
+        render_threaded_frame(frame);
+
+        {
+            std::lock_guard guard(rt.lock);
+            rt.busy = false;
+        }
+
+        rt.cv.notify_all();
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
+
+void glfw_backend::render_threaded_frame(const glfw_threaded_frame& frame)
+{
+    glfw_render_thread& rt = *threaded;
+
+    glWaitSync(frame.upload_fence, 0, GL_TIMEOUT_IGNORED);
+    glDeleteSync(frame.upload_fence);
+
+    if(rt.applied_vsync != (int)frame.vsync)
+    {
+        glfwSwapInterval(frame.vsync ? 1 : 0);
+        rt.applied_vsync = frame.vsync;
+    }
+
+    if(frame.screen_dirty || targets.size() == 0 || targets.get_dim() != frame.dim)
+        create_screen(frame.dim);
+
+    rt.rendering_dim = frame.dim;
+
+    damage.enabled = frame.damage_enabled;
+
+    if(frame.damage_invalidate)
+        damage.invalidate();
+
+    vec2i dim = frame.dim;
+
+    ///stands in for the swap when nothing is presented, which also paces the calling thread, whether or not vsync is on
+    auto skip = [&]()
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(1000000 / frame.refresh));
+    };
+
+    if(frame.snapshot == nullptr)
+    {
+        if(damage.enabled)
+            return skip();
+
+        presenter.present(targets.last().fbo, targets.last().tex, dim, frame.linear_colour);
+
+        glfwSwapBuffers(ctx.window);
+        return;
+    }
+
+    ImDrawData* data = &frame.snapshot->data;
+
+    glViewport(0, 0, dim.x(), dim.y());
+
+    bind_render_target();
+
+    if(damage.enabled)
+    {
+        if(!damage.update(data))
+            return skip();
+
+        damage.clear_and_clip(data);
+    }
+    else
+    {
+        glClearColor(0,0,0,1);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    ImGui_ImplOpenGL3_RenderDrawData(data);
+
+    presenter.present(targets.get().fbo, targets.get().tex, dim, frame.linear_colour);
+
+    if(!damage.enabled)
+        targets.release();
+
+    glfwSwapBuffers(ctx.window);
+}
+
 bool glfw_backend::has_dropped_file()
 {
     return dropped.size() > 0;
@@ -803,6 +1160,15 @@ void glfw_backend::pop_dropped_file()
     dropped.erase(dropped.begin());
 }
 
+std::vector<dropped_file_progress> glfw_backend::get_dropped_file_progress()
+{
+    #ifdef __EMSCRIPTEN__
+    return emscripten_drag_drop::get_progress();
+    #else
+    return drop_loader.get_progress();
+    #endif // __EMSCRIPTEN__
+}
+
 opencl_context* glfw_backend::get_opencl_context()
 {
     return clctx;
@@ -11,20 +11,18 @@
 #include <imgui/imgui.h>
 #include <networking/serialisable_fwd.hpp>
 #include "clock.hpp"
+#include "screen_presenter.hpp"
+#include "render_target_ring.hpp"
+#include <memory>
 
 struct GLFWwindow;
+struct glfw_render_thread;
+struct glfw_threaded_frame;
 struct opencl_context;
 struct render_settings;
 
 struct glfw_render_context
 {
-    bool screens_init = false;
-    unsigned int fbo;
-    unsigned int screen_tex;
-
-    unsigned int fbo_srgb;
-    unsigned int screen_tex_srgb;
-
     GLFWwindow* window = nullptr;
     ImFontAtlas atlas = {};
 
@@ -49,9 +47,14 @@ struct glfw_backend : generic_backend
     //void set_srgb(bool enabled) override;
     bool is_vsync() override;
     void set_vsync(bool enabled) override;
+    void set_damage_tracking(bool enabled) override;
+    void invalidate_damage() override;
     void poll(double maximum_sleep_s = 0) override;
     void poll_events_only(double maximum_sleep_s = 0) override;
     void poll_issue_new_frame_only() override;
+    void wait_events(double timeout_s) override;
+    void wake() override;
+    bool is_minimised() override;
 
     void display_bind_and_clear() override;
     void display_render() override;
@@ -71,14 +74,41 @@ struct glfw_backend : generic_backend
     void set_is_maximised(bool set_max) override;
     void clear_demaximise_cache() override;
     bool is_focused() override;
+    bool is_render_threaded() override;
+    void make_context_current_for_teardown() override;
 
     bool has_dropped_file() override;
     dropped_file get_next_dropped_file() override;
     void pop_dropped_file() override;
+    std::vector<dropped_file_progress> get_dropped_file_progress() override;
 
     vec2i last_size;
 private:
     bool closing = false;
     std::vector<dropped_file> dropped;
     bool is_vsync_enabled = false;
+    damage_tracker damage;
+    screen_presenter presenter;
+    ///declared after ctx, so that the targets are deleted while the gl context still exists
+    render_target_ring targets;
+    int frames_in_flight = 1;
+
+    ///waits for the next render target to be free, and binds it for drawing
+    void bind_render_target();
+    ///init_screen's gl work, which has to happen on whichever thread renders
+    void create_screen(vec2i dim);
+
+    ///null unless render_settings::render_thread is set
+    std::unique_ptr<glfw_render_thread> threaded;
+
+    ///declared after ctx, as its worker wakes the window up
+    dropped_file_loader drop_loader;
+
+    ///snapshots the draw data if there is any and hands it to the render thread, waiting for the previous frame to be submitted first
+    void submit_threaded(ImDrawData* data);
+    void render_thread_main(ImGuiContext* imgui_ctx);
+    void render_threaded_frame(const glfw_threaded_frame& frame);
+
+    ///stands in for the vsync wait when a frame isn't presented, so that an unchanged ui doesn't spin
+    void skip_present();
 };
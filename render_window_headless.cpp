@@ -0,0 +1,286 @@
+#ifdef USE_HEADLESS
+#include "render_window_headless.hpp"
+#include <imgui/imgui.h>
+#include <imgui/imgui_internal.h>
+#include <imgui/misc/freetype/imgui_freetype.h>
+#include <imgui/backends/imgui_impl_opengl3.h>
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdexcept>
+#include <string.h>
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    EGLDisplay get_surfaceless_display()
+    {
+        #ifdef EGL_MESA_platform_surfaceless
+        PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+        if(get_platform_display)
+        {
+            EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+            if(display != EGL_NO_DISPLAY)
+                return display;
+        }
+        #endif
+
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    uint8_t encode_srgb(float val)
+    {
+        val = std::clamp(val, 0.f, 1.f);
+
+        float encoded = val <= 0.0031308f ? val * 12.92f : 1.055f * std::pow(val, 1/2.4f) - 0.055f;
+
+        return (uint8_t)std::round(encoded * 255.f);
+    }
+
+    uint8_t encode_linear(float val)
+    {
+        return (uint8_t)std::round(std::clamp(val, 0.f, 1.f) * 255.f);
+    }
+}
+
+headless_render_context::headless_render_context(const render_settings& sett)
+{
+    EGLDisplay egl_display = get_surfaceless_display();
+
+    if(egl_display == EGL_NO_DISPLAY)
+        throw std::runtime_error("No egl display");
+
+    if(!eglInitialize(egl_display, nullptr, nullptr))
+        throw std::runtime_error("Could not init egl");
+
+    display = egl_display;
+
+    const char* extensions = eglQueryString(egl_display, EGL_EXTENSIONS);
+
+    if(extensions == nullptr || strstr(extensions, "EGL_KHR_surfaceless_context") == nullptr)
+        throw std::runtime_error("No EGL_KHR_surfaceless_context");
+
+    if(!eglBindAPI(EGL_OPENGL_API))
+        throw std::runtime_error("No desktop gl through egl");
+
+    EGLint config_attributes[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+
+    EGLConfig config = nullptr;
+    EGLint config_count = 0;
+
+    if(!eglChooseConfig(egl_display, config_attributes, &config, 1, &config_count) || config_count == 0)
+        throw std::runtime_error("No egl config");
+
+    EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 0,
+        EGL_NONE
+    };
+
+    EGLContext egl_context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, context_attributes);
+
+    if(egl_context == EGL_NO_CONTEXT)
+        throw std::runtime_error("Could not create egl context");
+
+    context = egl_context;
+
+    if(!eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context))
+        throw std::runtime_error("Could not make egl context current");
+
+    GLenum glew_err = glewInit();
+
+    ///a glx build of glew looks for a glx display, but still loads every entry point
+    #ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if(glew_err == GLEW_ERROR_NO_GLX_DISPLAY)
+        glew_err = GLEW_OK;
+    #endif
+
+    if(glew_err != GLEW_OK)
+        throw std::runtime_error("Bad Glew");
+
+    atlas.FontBuilderFlags = ImGuiFreeTypeBuilderFlags_LCD | ImGuiFreeTypeBuilderFlags_FILTER_DEFAULT | ImGuiFreeTypeBuilderFlags_LoadColor;
+
+    ImGui::CreateContext(&atlas);
+
+    ImGuiIO& io = ImGui::GetIO();
+
+    io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+    io.IniFilename = nullptr;
+
+    ImGuiStyle& style = ImGui::GetStyle();
+
+    style.FrameRounding = 0;
+    style.WindowRounding = 0;
+    style.ChildRounding = 0;
+    style.ChildBorderSize = 0;
+    style.FrameBorderSize = 0;
+    style.WindowBorderSize = 1;
+
+    if(sett.is_srgb)
+        ImGui::SetStyleLinearColor(true);
+
+    io.Fonts->Clear();
+    io.Fonts->AddFontDefault();
+
+    ImGui_ImplOpenGL3_Init("#version 130");
+}
+
+headless_render_context::~headless_render_context()
+{
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui::DestroyContext();
+
+    eglMakeCurrent((EGLDisplay)display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext((EGLDisplay)display, (EGLContext)context);
+    eglTerminate((EGLDisplay)display);
+}
+
+headless_backend::headless_backend(const render_settings& sett) : ctx(sett)
+{
+    frames_in_flight = sett.frames_in_flight;
+}
+
+headless_backend::~headless_backend()
+{
+    targets.destroy();
+}
+
+void headless_backend::init_screen(vec2i _dim)
+{
+    if(_dim.x() < 32)
+        _dim.x() = 32;
+
+    if(_dim.y() < 32)
+        _dim.y() = 32;
+
+    dim = _dim;
+
+    targets.create(frames_in_flight, dim);
+}
+
+vec2i headless_backend::get_window_size()
+{
+    return dim;
+}
+
+void headless_backend::resize(vec2i _dim)
+{
+    if(_dim == dim)
+        return;
+
+    init_screen(_dim);
+}
+
+void headless_backend::poll_events_only(double maximum_sleep_s)
+{
+    (void)maximum_sleep_s;
+
+    ImGui_ImplOpenGL3_NewFrame();
+
+    ImGuiIO& io = ImGui::GetIO();
+
+    io.DisplaySize = ImVec2(dim.x(), dim.y());
+    io.DisplayFramebufferScale = ImVec2(1, 1);
+
+    double elapsed = frame_clock.restart();
+
+    if(fixed_frame_time_s > 0)
+        elapsed = fixed_frame_time_s;
+
+    ///imgui asserts on a zero delta time
+    io.DeltaTime = std::max(elapsed, 1e-6);
+}
+
+void headless_backend::poll_issue_new_frame_only()
+{
+    ImGui::NewFrame();
+}
+
+void headless_backend::poll(double maximum_sleep_s)
+{
+    poll_events_only(maximum_sleep_s);
+    poll_issue_new_frame_only();
+}
+
+void headless_backend::display_bind_and_clear()
+{
+    glViewport(0, 0, dim.x(), dim.y());
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targets.acquire().fbo);
+
+    glClearColor(0,0,0,1);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void headless_backend::display_render()
+{
+    ImGui::Render();
+
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+    ///there's no swap to push the frame to the gpu
+    glFlush();
+
+    targets.release();
+}
+
+void headless_backend::finish()
+{
+    glFinish();
+}
+
+std::vector<uint8_t> headless_backend::read_frame()
+{
+    std::vector<float> linear;
+    linear.resize((size_t)dim.x() * dim.y() * 4);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, targets.last().fbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    glReadPixels(0, 0, dim.x(), dim.y(), GL_RGBA, GL_FLOAT, linear.data());
+
+    bool is_linear = ImGui::GetCurrentContext()->IsLinearColor;
+
+    std::vector<uint8_t> ret;
+    ret.resize(linear.size());
+
+    size_t row_floats = (size_t)dim.x() * 4;
+
+    ///gl's origin is the bottom left
+    for(int y=0; y < dim.y(); y++)
+    {
+        const float* src = &linear[(size_t)(dim.y() - 1 - y) * row_floats];
+        uint8_t* dst = &ret[(size_t)y * row_floats];
+
+        for(size_t i=0; i < row_floats; i++)
+        {
+            bool is_alpha = (i % 4) == 3;
+
+            dst[i] = (is_linear && !is_alpha) ? encode_srgb(src[i]) : encode_linear(src[i]);
+        }
+    }
+
+    return ret;
+}
+
+bool headless_backend::should_close()
+{
+    return closing;
+}
+
+void headless_backend::close()
+{
+    closing = true;
+}
+#endif // USE_HEADLESS
@@ -0,0 +1,62 @@
+#ifndef RENDER_WINDOW_HEADLESS_HPP_INCLUDED
+#define RENDER_WINDOW_HEADLESS_HPP_INCLUDED
+
+#include "render_window.hpp"
+#include "render_target_ring.hpp"
+#include "clock.hpp"
+#include <vec/vec.hpp>
+#include <imgui/imgui.h>
+#include <vector>
+#include <stdint.h>
+
+///an egl surfaceless context, with no window or default framebuffer. Needs EGL_KHR_surfaceless_context, which mesa's llvmpipe provides without a gpu
+struct headless_render_context
+{
+    void* display = nullptr;
+    void* context = nullptr;
+
+    ImFontAtlas atlas = {};
+
+    headless_render_context(const render_settings& sett);
+    ~headless_render_context();
+};
+
+///renders frames into an offscreen target and never presents them, for benchmarks and golden image tests on machines with no display
+///there's no input, so the ui only changes when the application changes it
+struct headless_backend : generic_backend
+{
+    headless_render_context ctx;
+
+    ///when non zero, this is used as every frame's delta time instead of the wall clock, so that runs are reproducible
+    double fixed_frame_time_s = 0;
+
+    headless_backend(const render_settings& sett);
+    ~headless_backend();
+
+    void poll(double maximum_sleep_s = 0) override;
+    void poll_events_only(double maximum_sleep_s = 0) override;
+    void poll_issue_new_frame_only() override;
+    void display_bind_and_clear() override;
+    void display_render() override;
+    bool should_close() override;
+    void close() override;
+    void init_screen(vec2i dim) override;
+    vec2i get_window_size() override;
+    void resize(vec2i dim) override;
+
+    ///blocks until the gpu has finished every submitted frame, so that timings cover rendering and not just submission
+    void finish();
+
+    ///the last displayed frame as tightly packed rgba8, with the top row first
+    ///linear colour frames are srgb encoded, so that they match what a window would have shown
+    std::vector<uint8_t> read_frame();
+
+private:
+    bool closing = false;
+    vec2i dim;
+    int frames_in_flight = 1;
+    steady_timer frame_clock;
+    render_target_ring targets;
+};
+
+#endif // RENDER_WINDOW_HEADLESS_HPP_INCLUDED
@@ -28,35 +28,6 @@
 #endif // __WIN32__
 #endif // __EMSCRIPTEN__
 
-namespace
-{
-void make_fbo(unsigned int* fboptr, unsigned int* tex, vec2i dim, bool is_srgb)
-{
-    int wx = dim.x();
-    int wy = dim.y();
-
-    glGenFramebuffers(1, fboptr);
-    glBindFramebuffer(GL_FRAMEBUFFER, *fboptr);
-
-    glGenTextures(1, tex);
-    glBindTexture(GL_TEXTURE_2D, *tex);
-
-    #ifndef __EMSCRIPTEN__
-    if(!is_srgb)
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, wx, wy, 0, GL_RGBA, GL_FLOAT, NULL);
-    else
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8, wx, wy, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    #else
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, wx, wy, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    #endif
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *tex, 0);
-}
-}
-
 sdl2_render_context::sdl2_render_context(const render_settings& lsett, const std::string& window_title)
 {
     render_settings sett = lsett;
@@ -187,13 +158,19 @@ sdl2_backend::sdl2_backend(const render_settings& sett, const std::string& windo
 {
     set_vsync(sett.vsync);
 
+    damage.enabled = sett.damage_tracking;
+    frames_in_flight = sett.frames_in_flight;
+
+    drop_loader.max_size = sett.max_dropped_file_size;
+    drop_loader.on_finished = [this](){wake();};
+
     #ifndef NO_OPENCL
     if(sett.opencl)
         clctx = new opencl_context;
     #endif // NO_OPENCL
 
     #ifdef __EMSCRIPTEN__
-    emscripten_drag_drop::init();
+    emscripten_drag_drop::init(sett.max_dropped_file_size);
     #endif // __EMSCRIPTEN__
 }
 
@@ -206,6 +183,20 @@ sdl2_backend::~sdl2_backend()
     }
 }
 
+void sdl2_backend::bind_render_target()
+{
+    frame_target& target = targets.acquire();
+
+    #ifndef NO_OPENCL
+    #ifndef NO_OPENCL_SCREEN
+    if(clctx)
+        clctx->cl_screen_index = targets.get_index();
+    #endif
+    #endif // NO_OPENCL
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.fbo);
+}
+
 void sdl2_backend::init_screen(vec2i dim)
 {
     if(dim.x() < 32)
@@ -214,15 +205,34 @@ void sdl2_backend::init_screen(vec2i dim)
     if(dim.y() < 32)
         dim.y() = 32;
 
-    make_fbo(&ctx.fbo, &ctx.screen_tex, dim, false);
-    make_fbo(&ctx.fbo_srgb, &ctx.screen_tex_srgb, dim, true);
+    ///the shared images have to go before the textures they wrap
+    #ifndef NO_OPENCL
+    #ifndef NO_OPENCL_SCREEN
+    if(clctx)
+    {
+        clctx->cl_screen_texs.clear();
+        clctx->cl_screen_index = 0;
+    }
+    #endif
+    #endif // NO_OPENCL
+
+    targets.create(frames_in_flight, dim);
+
+    damage.invalidate();
+    ///the default framebuffer may have changed along with the window, eg it moved to a different monitor
+    presenter.invalidate();
 
     #ifndef NO_OPENCL
     #ifndef NO_OPENCL_SCREEN
     if(clctx)
     {
-        clctx->cl_screen_tex.create_from_texture(ctx.screen_tex);
+        for(int i=0; i < targets.size(); i++)
+        {
+            clctx->cl_screen_texs.emplace_back(clctx->ctx).create_from_texture(targets.get_nth(i).tex);
+        }
+
         clctx->cl_image.alloc(dim, cl_image_format{CL_RGBA, CL_FLOAT});
+        clctx->alloc_frost_chain(dim);
     }
     #endif
     #endif // NO_OPENCL
@@ -287,6 +297,27 @@ void sdl2_backend::set_vsync(bool enabled)
     }
 }
 
+void sdl2_backend::wait_events(double timeout_s)
+{
+    if(timeout_s < 0)
+        SDL_WaitEvent(nullptr);
+    else
+        SDL_WaitEventTimeout(nullptr, (int)(timeout_s * 1000));
+}
+
+void sdl2_backend::wake()
+{
+    SDL_Event e = {};
+    e.type = SDL_USEREVENT;
+
+    SDL_PushEvent(&e);
+}
+
+bool sdl2_backend::is_minimised()
+{
+    return (SDL_GetWindowFlags(ctx.window) & SDL_WINDOW_MINIMIZED) != 0;
+}
+
 void sdl2_backend::poll_events_only(double maximum_sleep_s)
 {
     if(set_frames > 0)
@@ -341,17 +372,10 @@ void sdl2_backend::poll_events_only(double maximum_sleep_s)
             std::string name = e.drop.file;
             SDL_free(e.drop.file);
 
-            std::string data = file::read(name, file::mode::TEXT);
-
-            dropped_file fle;
-            fle.name = name;
-
             std::cout << "Dropped file " << name << std::endl;
 
             //fle.name = std::filesystem::path(name).filename().string();
-            fle.data = data;
-
-            dropped.push_back(fle);
+            drop_loader.add(name, name);
         }
 
         if(e.type == SDL_WINDOWEVENT && e.window.windowID == SDL_GetWindowID(ctx.window))
@@ -377,6 +401,11 @@ void sdl2_backend::poll_events_only(double maximum_sleep_s)
     {
         dropped.push_back(i);
     }
+    #else
+    for(dropped_file& fle : drop_loader.take_finished())
+    {
+        dropped.push_back(std::move(fle));
+    }
     #endif // __EMSCRIPTEN__
 
     if(next_size != last_size)
@@ -405,15 +434,31 @@ void sdl2_backend::display()
 
     ImGui::Render();
 
+    bool tracking = damage.enabled && (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable) == 0;
+
+    if(tracking && !damage.update(ImGui::GetDrawData()))
+    {
+        skip_present();
+        return;
+    }
+
     vec2i dim = get_window_size();
 
     SDL_GL_MakeCurrent(ctx.window, ctx.glcontext);
 
     glViewport(0, 0, dim.x(), dim.y());
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, ctx.fbo);
-    glClearColor(0,0,0,1);
-    glClear(GL_COLOR_BUFFER_BIT);
+    bind_render_target();
+
+    if(tracking)
+    {
+        damage.clear_and_clip(ImGui::GetDrawData());
+    }
+    else
+    {
+        glClearColor(0,0,0,1);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
 
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
@@ -426,36 +471,48 @@ void sdl2_backend::display()
         SDL_GL_MakeCurrent(backup_current_window, backup_current_context);
     }
 
-    if(ImGui::GetCurrentContext()->IsLinearColor)
-    {
-        glEnable(GL_FRAMEBUFFER_SRGB);
-
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, ctx.fbo_srgb);
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, ctx.fbo);
-
-        glBlitFramebuffer(0, 0, dim.x(), dim.y(), 0, 0, dim.x(), dim.y(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    presenter.present(targets.get().fbo, targets.get().tex, dim, ImGui::GetCurrentContext()->IsLinearColor);
 
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, ctx.fbo_srgb);
+    ///damage tracking redraws on top of the previous frame, so it always renders into the same target
+    if(!damage.enabled)
+        targets.release();
 
-        glBlitFramebuffer(0, 0, dim.x(), dim.y(), 0, 0, dim.x(), dim.y(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    SDL_GL_SwapWindow(ctx.window);
+}
 
-        glDisable(GL_FRAMEBUFFER_SRGB);
-    }
-    else
-    {
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, ctx.fbo);
+void sdl2_backend::display_last_frame()
+{
+    if(damage.enabled)
+        skip_present();
+}
 
-        glBlitFramebuffer(0, 0, dim.x(), dim.y(), 0, 0, dim.x(), dim.y(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
-    }
+void sdl2_backend::set_damage_tracking(bool enabled)
+{
+    damage.enabled = enabled;
+    damage.invalidate();
+}
 
-    SDL_GL_SwapWindow(ctx.window);
+void sdl2_backend::invalidate_damage()
+{
+    damage.invalidate();
 }
 
-void sdl2_backend::display_last_frame()
+///stands in for the swap that would have blocked, so that an unchanged ui doesn't spin, whether or not vsync is on
+void sdl2_backend::skip_present()
 {
+    ///the browser paces frames itself
+    #ifdef __EMSCRIPTEN__
+    return;
+    #endif // __EMSCRIPTEN__
+
+    SDL_DisplayMode mode = {};
 
+    int refresh = 60;
+
+    if(SDL_GetWindowDisplayMode(ctx.window, &mode) == 0 && mode.refresh_rate > 0)
+        refresh = mode.refresh_rate;
+
+    SDL_Delay(1000 / refresh);
 }
 
 bool sdl2_backend::should_close()
@@ -626,6 +683,15 @@ void sdl2_backend::pop_dropped_file()
     dropped.erase(dropped.begin());
 }
 
+std::vector<dropped_file_progress> sdl2_backend::get_dropped_file_progress()
+{
+    #ifdef __EMSCRIPTEN__
+    return emscripten_drag_drop::get_progress();
+    #else
+    return drop_loader.get_progress();
+    #endif // __EMSCRIPTEN__
+}
+
 opencl_context* sdl2_backend::get_opencl_context()
 {
     return clctx;
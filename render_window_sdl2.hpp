@@ -3,15 +3,11 @@
 
 #include "render_window.hpp"
 #include <SDL2/SDL.h>
+#include "screen_presenter.hpp"
+#include "render_target_ring.hpp"
 
 struct sdl2_render_context
 {
-    unsigned int fbo;
-    unsigned int screen_tex;
-
-    unsigned int fbo_srgb;
-    unsigned int screen_tex_srgb;
-
     SDL_Window* window = nullptr;
     SDL_GLContext glcontext;
     ImFontAtlas atlas = {};
@@ -32,9 +28,14 @@ struct sdl2_backend : generic_backend
 
     bool is_vsync() override;
     void set_vsync(bool enabled) override;
+    void set_damage_tracking(bool enabled) override;
+    void invalidate_damage() override;
     void poll(double maximum_sleep_s = 0) override;
     void poll_events_only(double maximum_sleep_s = 0) override;
     void poll_issue_new_frame_only() override;
+    void wait_events(double timeout_s) override;
+    void wake() override;
+    bool is_minimised() override;
     void display() override;
     void display_last_frame() override;
     bool should_close() override;
@@ -52,6 +53,7 @@ struct sdl2_backend : generic_backend
     bool has_dropped_file() override;
     dropped_file get_next_dropped_file() override;
     void pop_dropped_file() override;
+    std::vector<dropped_file_progress> get_dropped_file_progress() override;
 
 private:
     bool closing = false;
@@ -60,6 +62,21 @@ private:
 
     vec2i next_position;
     int set_frames = 0;
+
+    damage_tracker damage;
+    screen_presenter presenter;
+    ///declared after ctx, so that the targets are deleted while the gl context still exists
+    render_target_ring targets;
+    int frames_in_flight = 1;
+
+    ///declared after ctx, as its worker wakes the window up
+    dropped_file_loader drop_loader;
+
+    ///waits for the next render target to be free, and binds it for drawing
+    void bind_render_target();
+
+    ///stands in for the vsync wait when a frame isn't presented, so that an unchanged ui doesn't spin
+    void skip_present();
 };
 
 
@@ -0,0 +1,118 @@
+#include "screen_presenter.hpp"
+#include <GL/glew.h>
+#include <GL/gl.h>
+#include <iostream>
+
+namespace
+{
+    const char* encode_source = R"(
+uniform sampler2D tex;
+varying vec2 uv;
+
+void main()
+{
+    vec3 col = clamp(texture2D(tex, uv).rgb, 0.0, 1.0);
+
+    vec3 lo = col * 12.92;
+    vec3 hi = 1.055 * pow(col, vec3(1.0 / 2.4)) - 0.055;
+
+    gl_FragColor = vec4(mix(hi, lo, vec3(lessThanEqual(col, vec3(0.0031308)))), 1.0);
+}
+)";
+
+    void blit_to_default(unsigned int source_fbo, vec2i dim)
+    {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, source_fbo);
+
+        glBlitFramebuffer(0, 0, dim.x(), dim.y(), 0, 0, dim.x(), dim.y(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+}
+
+bool screen_presenter::probe_default_is_srgb()
+{
+    #ifndef __EMSCRIPTEN__
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    while(glGetError() != GL_NO_ERROR){}
+
+    GLint encoding = GL_LINEAR;
+
+    ///single buffered windows only have a front buffer
+    glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_BACK_LEFT, GL_FRAMEBUFFER_ATTACHMENT_COLOR_ENCODING, &encoding);
+
+    if(glGetError() != GL_NO_ERROR)
+    {
+        encoding = GL_LINEAR;
+
+        glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_FRONT_LEFT, GL_FRAMEBUFFER_ATTACHMENT_COLOR_ENCODING, &encoding);
+
+        if(glGetError() != GL_NO_ERROR)
+            return false;
+    }
+
+    return encoding == GL_SRGB;
+    #else
+    return false;
+    #endif
+}
+
+void screen_presenter::invalidate()
+{
+    default_is_srgb = -1;
+}
+
+void screen_presenter::present(unsigned int source_fbo, unsigned int source_tex, vec2i dim, bool linear_colour)
+{
+    if(!linear_colour)
+    {
+        blit_to_default(source_fbo, dim);
+        return;
+    }
+
+    if(default_is_srgb == -1)
+        default_is_srgb = probe_default_is_srgb();
+
+    if(default_is_srgb)
+    {
+        glEnable(GL_FRAMEBUFFER_SRGB);
+
+        blit_to_default(source_fbo, dim);
+
+        glDisable(GL_FRAMEBUFFER_SRGB);
+        return;
+    }
+
+    if(!encode.is_valid() && !encode_failed)
+    {
+        encode_failed = !encode.load(encode_source);
+
+        if(encode_failed)
+            std::cout << "No srgb framebuffer and no srgb encode shader, colours will be wrong" << std::endl;
+    }
+
+    if(encode_failed)
+    {
+        blit_to_default(source_fbo, dim);
+        return;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, dim.x(), dim.y());
+
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_BLEND);
+
+    #ifndef __EMSCRIPTEN__
+    glBindVertexArray(0);
+    #endif
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, source_tex);
+
+    encode.bind();
+    encode.set_uniform("tex", 0);
+    encode.draw_fullscreen();
+
+    glUseProgram(0);
+}
@@ -0,0 +1,27 @@
+#ifndef SCREEN_PRESENTER_HPP_INCLUDED
+#define SCREEN_PRESENTER_HPP_INCLUDED
+
+#include <vec/vec.hpp>
+#include "gl_shader.hpp"
+
+///copies the offscreen render target to the default framebuffer
+///in linear colour mode this also encodes to srgb. If the default framebuffer is srgb capable that's a single blit, otherwise it's one fullscreen shader pass
+struct screen_presenter
+{
+    ///gl thread only, with the window's context current. Leaves the default framebuffer bound
+    void present(unsigned int source_fbo, unsigned int source_tex, vec2i dim, bool linear_colour);
+
+    ///reprobes the default framebuffer on the next present. The backends call this whenever they recreate their render targets
+    void invalidate();
+
+private:
+    ///-1 until probed
+    int default_is_srgb = -1;
+
+    gl_shader encode;
+    bool encode_failed = false;
+
+    bool probe_default_is_srgb();
+};
+
+#endif // SCREEN_PRESENTER_HPP_INCLUDED
@@ -0,0 +1,148 @@
+///g++ -std=c++17 -Ideps -I. tests/atlas_packer_test.cpp atlas_packer.cpp -o atlas_packer_test
+#include "atlas_packer.hpp"
+#include <vector>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(x) do{if(!(x)){printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #x); exit(1);}}while(0)
+
+namespace
+{
+    bool overlaps(const atlas_rect& r1, const atlas_rect& r2)
+    {
+        return r1.pos.x() < r2.pos.x() + r2.dim.x() && r2.pos.x() < r1.pos.x() + r1.dim.x() &&
+               r1.pos.y() < r2.pos.y() + r2.dim.y() && r2.pos.y() < r1.pos.y() + r1.dim.y();
+    }
+
+    bool inside(const atlas_rect& r, vec2i page)
+    {
+        return r.pos.x() >= 0 && r.pos.y() >= 0 && r.pos.x() + r.dim.x() <= page.x() && r.pos.y() + r.dim.y() <= page.y();
+    }
+
+    std::optional<atlas_rect> insert(atlas_packer& packer, std::vector<atlas_rect>& used, vec2i dim, vec2i page)
+    {
+        std::optional<vec2i> pos = packer.find(dim);
+
+        if(!pos.has_value())
+            return std::nullopt;
+
+        atlas_rect r = {pos.value(), dim};
+
+        CHECK(inside(r, page));
+
+        for(const atlas_rect& other : used)
+            CHECK(!overlaps(r, other));
+
+        packer.place(r);
+        used.push_back(r);
+
+        ///free space must never cover anything in use
+        for(const atlas_rect& f : packer.free_rects)
+        {
+            for(const atlas_rect& other : used)
+                CHECK(!overlaps(f, other));
+        }
+
+        return r;
+    }
+
+    void test_exact_fill()
+    {
+        vec2i page = {64, 64};
+
+        atlas_packer packer;
+        packer.reset(page);
+
+        std::vector<atlas_rect> used;
+
+        for(int i=0; i < 16; i++)
+            CHECK(insert(packer, used, {16, 16}, page).has_value());
+
+        CHECK(!packer.find({1, 1}).has_value());
+
+        ///evicting a tile makes exactly that tile available again
+        atlas_rect freed = used[5];
+        used.erase(used.begin() + 5);
+        packer.release(freed);
+
+        CHECK(!packer.find({17, 16}).has_value());
+        CHECK(insert(packer, used, {16, 16}, page).has_value());
+        CHECK(!packer.find({1, 1}).has_value());
+    }
+
+    void test_neighbours_merge()
+    {
+        vec2i page = {64, 32};
+
+        atlas_packer packer;
+        packer.reset(page);
+
+        std::vector<atlas_rect> used;
+
+        for(int i=0; i < 4; i++)
+            CHECK(insert(packer, used, {16, 32}, page).has_value());
+
+        CHECK(!packer.find({1, 1}).has_value());
+
+        ///two adjacent evictions join up into space for something bigger than either
+        atlas_rect r0 = used[0];
+        atlas_rect r1 = used[1];
+
+        CHECK(r0.pos.y() == r1.pos.y() && (r0.pos.x() + 16 == r1.pos.x() || r1.pos.x() + 16 == r0.pos.x()));
+
+        used.erase(used.begin(), used.begin() + 2);
+        packer.release(r0);
+        packer.release(r1);
+
+        CHECK(insert(packer, used, {32, 32}, page).has_value());
+    }
+
+    void test_random_churn()
+    {
+        vec2i page = {256, 256};
+
+        atlas_packer packer;
+        packer.reset(page);
+
+        std::vector<atlas_rect> used;
+        std::minstd_rand rng(1234);
+
+        for(int i=0; i < 1500; i++)
+        {
+            if(used.size() > 0 && rng() % 3 == 0)
+            {
+                int idx = rng() % used.size();
+
+                atlas_rect r = used[idx];
+                used.erase(used.begin() + idx);
+                packer.release(r);
+                continue;
+            }
+
+            vec2i dim = {1 + (int)(rng() % 48), 1 + (int)(rng() % 48)};
+
+            insert(packer, used, dim, page);
+        }
+
+        ///evicted space is reused, rather than leaking
+        while(used.size() > 0)
+        {
+            packer.release(used.back());
+            used.pop_back();
+        }
+
+        CHECK(packer.find(page).has_value());
+    }
+}
+
+int main()
+{
+    test_exact_fill();
+    test_neighbours_merge();
+    test_random_churn();
+
+    printf("atlas_packer_test passed\n");
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+///g++ -std=c++17 -Ideps -I. tests/fs_async_test.cpp fs_async.cpp fs_helpers.cpp fs_pack.cpp clock.cpp -lpthread -o fs_async_test
+#include "fs_async.hpp"
+#include "fs_helpers.hpp"
+#include <vector>
+#include <string>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(x) do{if(!(x)){printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #x); exit(1);}}while(0)
+
+namespace
+{
+    const std::string dir = "fs_async_test_tmp";
+
+    ///the sizes shrink, so a write that lands out of order leaves the file the wrong length, and one that interleaves leaves the wrong bytes
+    std::string contents(int i)
+    {
+        return std::string(64 * 1024 - i * 97, (char)('a' + i % 26));
+    }
+
+    void test_write_write()
+    {
+        std::string path = dir + "/write_write";
+
+        std::mutex lock;
+        std::vector<int> completed;
+        std::future<bool> last;
+
+        {
+            file::async::batch b;
+
+            for(int i=0; i < 32; i++)
+            {
+                file::async::write(path, contents(i), file::mode::BINARY, [&, i](bool ok)
+                {
+                    CHECK(ok);
+
+                    std::lock_guard guard(lock);
+                    completed.push_back(i);
+                });
+            }
+
+            last = file::async::write(path, contents(32), file::mode::BINARY);
+        }
+
+        CHECK(last.get());
+
+        std::lock_guard guard(lock);
+
+        CHECK(completed.size() == 32);
+
+        for(int i=0; i < (int)completed.size(); i++)
+            CHECK(completed[i] == i);
+
+        CHECK(file::read(path, file::mode::BINARY) == contents(32));
+    }
+
+    void test_write_read()
+    {
+        std::string path = dir + "/write_read";
+
+        file::write(path, contents(0), file::mode::BINARY);
+
+        std::vector<std::future<std::string>> reads;
+
+        {
+            file::async::batch b;
+
+            for(int i=1; i < 16; i++)
+            {
+                file::async::write(path, contents(i), file::mode::BINARY);
+                reads.push_back(file::async::read(path, file::mode::BINARY));
+            }
+        }
+
+        for(int i=0; i < (int)reads.size(); i++)
+            CHECK(reads[i].get() == contents(i + 1));
+    }
+
+    void test_read_held_back()
+    {
+        std::string path = dir + "/held_back";
+
+        file::write(path, contents(0), file::mode::BINARY);
+
+        std::future<std::string> read;
+        std::future<bool> exists;
+        std::shared_future<void> landed;
+
+        {
+            file::manual_fs_sync sync;
+
+            file::write(path, contents(1), file::mode::BINARY);
+            file::write(path + "_new", contents(2), file::mode::BINARY);
+
+            read = file::async::read(path, file::mode::BINARY);
+            exists = file::async::exists(path + "_new");
+
+            landed = sync.completion();
+        }
+
+        CHECK(read.get() == contents(1));
+        CHECK(exists.get());
+
+        landed.wait();
+    }
+
+    void test_write_supersedes_held_back()
+    {
+        std::string path = dir + "/superseded";
+
+        std::shared_future<void> landed;
+
+        {
+            file::manual_fs_sync sync;
+
+            file::write(path, contents(0), file::mode::BINARY);
+
+            CHECK(file::async::write(path, contents(1), file::mode::BINARY).get());
+
+            landed = sync.completion();
+        }
+
+        landed.wait();
+
+        CHECK(file::read(path, file::mode::BINARY) == contents(1));
+    }
+}
+
+int main()
+{
+    file::mkdir(dir);
+
+    printf("fs_async_test running through %s\n", file::async::is_io_uring() ? "io_uring" : "the thread pool");
+
+    test_write_write();
+    test_write_read();
+    test_read_held_back();
+    test_write_supersedes_held_back();
+
+    printf("fs_async_test passed\n");
+
+    return 0;
+}
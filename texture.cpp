@@ -1,6 +1,584 @@
 #include "texture.hpp"
+#include "texture_compression.hpp"
 #include <GL/glew.h>
 #include <GL/gl.h>
+#ifdef __EMSCRIPTEN__
+#include <emscripten/html5.h>
+#endif
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <string.h>
+#include <assert.h>
+#include <stdexcept>
+#include <algorithm>
+
+namespace
+{
+    struct pixel_buffer
+    {
+        unsigned int pbo = 0;
+        uint8_t* mapped = nullptr;
+        size_t size = 0;
+        bool persistent = false;
+        GLsync fence = nullptr;
+    };
+
+    ///gl thread only. Buffers are recycled once the gpu has finished reading out of them
+    std::vector<pixel_buffer> free_pixel_buffers;
+    constexpr int max_free_pixel_buffers = 8;
+
+    bool is_signalled(GLsync fence)
+    {
+        if(fence == nullptr)
+            return true;
+
+        return glClientWaitSync(fence, 0, 0) != GL_TIMEOUT_EXPIRED;
+    }
+
+    pixel_buffer acquire_pixel_buffer(size_t bytes)
+    {
+        int best = -1;
+
+        for(int i=0; i < (int)free_pixel_buffers.size(); i++)
+        {
+            const pixel_buffer& buf = free_pixel_buffers[i];
+
+            if(buf.size < bytes || !is_signalled(buf.fence))
+                continue;
+
+            if(best == -1 || buf.size < free_pixel_buffers[best].size)
+                best = i;
+        }
+
+        pixel_buffer ret;
+
+        if(best != -1)
+        {
+            ret = free_pixel_buffers[best];
+            free_pixel_buffers.erase(free_pixel_buffers.begin() + best);
+
+            if(ret.fence)
+            {
+                glDeleteSync(ret.fence);
+                ret.fence = nullptr;
+            }
+        }
+        else
+        {
+            ret.size = bytes;
+            ret.persistent = GLEW_ARB_buffer_storage || GLEW_VERSION_4_4;
+
+            glGenBuffers(1, &ret.pbo);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ret.pbo);
+
+            if(ret.persistent)
+            {
+                GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+                glBufferStorage(GL_PIXEL_UNPACK_BUFFER, ret.size, nullptr, flags);
+                ret.mapped = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, ret.size, flags);
+            }
+            else
+            {
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, ret.size, nullptr, GL_STREAM_DRAW);
+            }
+
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+
+        if(!ret.persistent)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ret.pbo);
+            ret.mapped = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, ret.size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+
+        if(ret.mapped == nullptr)
+            throw std::runtime_error("Could not map pixel buffer for texture upload");
+
+        return ret;
+    }
+
+    void release_pixel_buffer(pixel_buffer buf)
+    {
+        if(free_pixel_buffers.size() < max_free_pixel_buffers)
+        {
+            free_pixel_buffers.push_back(buf);
+            return;
+        }
+
+        if(buf.fence)
+            glDeleteSync(buf.fence);
+
+        glDeleteBuffers(1, &buf.pbo);
+    }
+
+    struct pack_buffer
+    {
+        unsigned int pbo = 0;
+        size_t size = 0;
+        GLsync fence = nullptr;
+    };
+
+    ///gl thread only. Readbacks which are dropped before they finish hand their buffer back with its fence, so it isn't reused while the gpu is still writing to it
+    std::vector<pack_buffer> free_pack_buffers;
+    constexpr int max_free_pack_buffers = 8;
+
+    pack_buffer acquire_pack_buffer(size_t bytes)
+    {
+        int best = -1;
+
+        for(int i=0; i < (int)free_pack_buffers.size(); i++)
+        {
+            const pack_buffer& buf = free_pack_buffers[i];
+
+            if(buf.size < bytes || !is_signalled(buf.fence))
+                continue;
+
+            if(best == -1 || buf.size < free_pack_buffers[best].size)
+                best = i;
+        }
+
+        pack_buffer ret;
+
+        if(best != -1)
+        {
+            ret = free_pack_buffers[best];
+            free_pack_buffers.erase(free_pack_buffers.begin() + best);
+
+            if(ret.fence)
+            {
+                glDeleteSync(ret.fence);
+                ret.fence = nullptr;
+            }
+
+            return ret;
+        }
+
+        ret.size = bytes;
+
+        glGenBuffers(1, &ret.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, ret.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, ret.size, nullptr, GL_STREAM_READ);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        return ret;
+    }
+
+    void release_pack_buffer(pack_buffer buf)
+    {
+        if(free_pack_buffers.size() < max_free_pack_buffers)
+        {
+            free_pack_buffers.push_back(buf);
+            return;
+        }
+
+        if(buf.fence)
+            glDeleteSync(buf.fence);
+
+        glDeleteBuffers(1, &buf.pbo);
+    }
+}
+
+namespace
+{
+    int calculate_mip_levels(vec2i dim)
+    {
+        int largest = std::max(dim.x(), dim.y());
+        int levels = 1;
+
+        while(largest > 1)
+        {
+            largest /= 2;
+            levels++;
+        }
+
+        return levels;
+    }
+
+    struct format_info
+    {
+        GLenum internal_format = 0;
+        GLenum upload_format = GL_RGBA;
+        GLenum upload_type = GL_UNSIGNED_BYTE;
+        int input_bytes = 4;
+        bool compressed = false;
+    };
+
+    format_info get_format_info(texture_format::type fmt, bool is_srgb)
+    {
+        switch(fmt)
+        {
+            case texture_format::RGBA8:
+                return {is_srgb ? (GLenum)GL_SRGB8_ALPHA8 : (GLenum)GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, false};
+            case texture_format::RGBA16F:
+                return {GL_RGBA16F, GL_RGBA, GL_FLOAT, 16, false};
+            case texture_format::RGBA32F:
+                return {GL_RGBA32F, GL_RGBA, GL_FLOAT, 16, false};
+            case texture_format::R8:
+                return {GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1, false};
+            case texture_format::RG8:
+                return {GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2, false};
+            case texture_format::BC1:
+                return {is_srgb ? (GLenum)GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : (GLenum)GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_RGBA, GL_UNSIGNED_BYTE, 4, true};
+            case texture_format::BC3:
+                return {is_srgb ? (GLenum)GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : (GLenum)GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_RGBA, GL_UNSIGNED_BYTE, 4, true};
+            case texture_format::BC4:
+                return {GL_COMPRESSED_RED_RGTC1, GL_RGBA, GL_UNSIGNED_BYTE, 4, true};
+            case texture_format::BC5:
+                return {GL_COMPRESSED_RG_RGTC2, GL_RGBA, GL_UNSIGNED_BYTE, 4, true};
+            case texture_format::BC7:
+                return {is_srgb ? (GLenum)GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : (GLenum)GL_COMPRESSED_RGBA_BPTC_UNORM, GL_RGBA, GL_UNSIGNED_BYTE, 4, true};
+            case texture_format::ETC2_RGB8:
+                return {is_srgb ? (GLenum)GL_COMPRESSED_SRGB8_ETC2 : (GLenum)GL_COMPRESSED_RGB8_ETC2, GL_RGBA, GL_UNSIGNED_BYTE, 4, true};
+            case texture_format::ETC2_RGBA8:
+                return {is_srgb ? (GLenum)GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC : (GLenum)GL_COMPRESSED_RGBA8_ETC2_EAC, GL_RGBA, GL_UNSIGNED_BYTE, 4, true};
+        }
+
+        throw std::runtime_error("Unknown texture format " + std::to_string((int)fmt));
+    }
+
+    ///rows of r8/rg8/odd width textures aren't 4 byte aligned
+    struct unpack_alignment_setter
+    {
+        GLint old = 4;
+
+        unpack_alignment_setter(int64_t row_bytes)
+        {
+            glGetIntegerv(GL_UNPACK_ALIGNMENT, &old);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, (row_bytes % 4) == 0 ? 4 : 1);
+        }
+
+        ~unpack_alignment_setter()
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, old);
+        }
+    };
+
+    ///encoded on the cpu, rather than handed to the driver as raw texels
+    bool is_cpu_compressed(texture_format::type fmt)
+    {
+        return texture_format::is_compressed(fmt) && texture_compression::can_encode(fmt);
+    }
+
+    ///few drivers compress bptc or etc2 themselves, and etc2 is usually emulated by decompressing it, so raw texels for a format without an encoder are stored as RGBA8
+    texture_settings resolve_raw_format(texture_settings settings)
+    {
+        if(texture_format::is_compressed(settings.format) && !texture_compression::can_encode(settings.format))
+            settings.format = texture_format::RGBA8;
+
+        return settings;
+    }
+
+    bool is_same_storage(const texture_settings& s1, const texture_settings& s2)
+    {
+        return s1.width == s2.width && s1.height == s2.height && s1.is_srgb == s2.is_srgb && s1.generate_mipmaps == s2.generate_mipmaps && s1.format == s2.format;
+    }
+
+    void set_filtering(const texture_settings& settings)
+    {
+        if(settings.shrink_linear)
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        else
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+        if(settings.magnify_linear)
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        else
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+
+    ///gl thread only
+    unsigned int mip_blit_fbos[2] = {};
+    unsigned int readback_fbo = 0;
+
+    bool is_power_of_two(int v)
+    {
+        return v > 0 && (v & (v - 1)) == 0;
+    }
+
+    ///there's no partial glGenerateMipmap, so each level is rebuilt from the one above it with a linear 2:1 blit, over only the touched area
+    void regenerate_mip_region(unsigned int handle, vec2i dim, vec2i pos, vec2i region, bool is_srgb)
+    {
+        int levels = calculate_mip_levels(dim);
+
+        if(levels <= 1)
+            return;
+
+        ///an odd sized level doesn't halve exactly, so a 2:1 blit would leave its last row or column out of the level below
+        if(!is_power_of_two(dim.x()) || !is_power_of_two(dim.y()))
+        {
+            glGenerateMipmapEXT(GL_TEXTURE_2D);
+            return;
+        }
+
+        if(mip_blit_fbos[0] == 0)
+        {
+            glGenFramebuffers(2, mip_blit_fbos);
+        }
+
+        GLint old_read = 0;
+        GLint old_draw = 0;
+
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &old_read);
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &old_draw);
+
+        GLboolean had_scissor = glIsEnabled(GL_SCISSOR_TEST);
+        glDisable(GL_SCISSOR_TEST);
+
+        #ifndef __EMSCRIPTEN__
+        ///otherwise the blit filters the encoded values, and every level comes out darker than the one above it
+        GLboolean had_srgb = glIsEnabled(GL_FRAMEBUFFER_SRGB);
+
+        if(is_srgb)
+            glEnable(GL_FRAMEBUFFER_SRGB);
+        else
+            glDisable(GL_FRAMEBUFFER_SRGB);
+        #endif
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, mip_blit_fbos[0]);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mip_blit_fbos[1]);
+
+        int x0 = pos.x();
+        int y0 = pos.y();
+        int x1 = pos.x() + region.x();
+        int y1 = pos.y() + region.y();
+
+        for(int level = 1; level < levels; level++)
+        {
+            vec2i src_size = max(dim / (1 << (level - 1)), (vec2i){1, 1});
+            vec2i dst_size = max(dim / (1 << level), (vec2i){1, 1});
+
+            ///widen the area so that it covers every texel in this level that reads from the touched area of the one above it
+            x0 = x0 / 2;
+            y0 = y0 / 2;
+            x1 = std::min((x1 + 1) / 2, dst_size.x());
+            y1 = std::min((y1 + 1) / 2, dst_size.y());
+
+            int sx0 = x0 * 2;
+            int sy0 = y0 * 2;
+            ///once an axis is down to 1 it stays there, and that axis is copied 1:1
+            int sx1 = std::min(x1 * 2, src_size.x());
+            int sy1 = std::min(y1 * 2, src_size.y());
+
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, handle, level - 1);
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, handle, level);
+
+            glBlitFramebuffer(sx0, sy0, sx1, sy1, x0, y0, x1, y1, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        }
+
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, old_read);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, old_draw);
+
+        if(had_scissor)
+            glEnable(GL_SCISSOR_TEST);
+
+        #ifndef __EMSCRIPTEN__
+        if(had_srgb)
+            glEnable(GL_FRAMEBUFFER_SRGB);
+        else
+            glDisable(GL_FRAMEBUFFER_SRGB);
+        #endif
+    }
+}
+
+struct texture_upload
+{
+    std::mutex lock;
+    std::condition_variable cv;
+    bool filled = false;
+    ///set if fill threw, and rethrown on the gl thread
+    std::exception_ptr error;
+
+    texture_settings settings;
+    pixel_buffer buffer;
+    bool issued = false;
+
+    ///for cpu compressed formats, the worker encodes the whole mip chain into the buffer
+    int compressed_levels = 0;
+    int64_t compressed_bytes = 0;
+
+    bool try_wait()
+    {
+        std::lock_guard guard(lock);
+        return filled;
+    }
+
+    void wait()
+    {
+        std::unique_lock guard(lock);
+        cv.wait(guard, [&](){return filled;});
+    }
+};
+
+namespace
+{
+    struct upload_setter
+    {
+        std::shared_ptr<texture_upload> upload;
+
+        upload_setter(std::shared_ptr<texture_upload> in) : upload(in){}
+
+        ~upload_setter()
+        {
+            {
+                std::lock_guard guard(upload->lock);
+                upload->filled = true;
+            }
+
+            upload->cv.notify_all();
+        }
+    };
+
+    ///fills run here rather than on a thread each, so loading hundreds of textures doesn't start hundreds of threads
+    struct upload_pool
+    {
+        std::mutex lock;
+        std::condition_variable cv;
+        std::deque<std::function<void()>> queue;
+        std::vector<std::thread> threads;
+        bool quit = false;
+
+        upload_pool()
+        {
+            int count = std::clamp((int)std::thread::hardware_concurrency() - 1, 1, 4);
+
+            for(int i=0; i < count; i++)
+            {
+                threads.emplace_back([this](){run();});
+            }
+        }
+
+        ~upload_pool()
+        {
+            {
+                std::lock_guard guard(lock);
+                quit = true;
+            }
+
+            cv.notify_all();
+
+            for(std::thread& t : threads)
+            {
+                t.join();
+            }
+        }
+
+        void add(std::function<void()> func)
+        {
+            {
+                std::lock_guard guard(lock);
+                queue.push_back(std::move(func));
+            }
+
+            cv.notify_one();
+        }
+
+        void run()
+        {
+            while(1)
+            {
+                std::function<void()> func;
+
+                {
+                    std::unique_lock guard(lock);
+
+                    cv.wait(guard, [&](){return quit || queue.size() > 0;});
+
+                    if(queue.size() == 0)
+                        return;
+
+                    func = std::move(queue.front());
+                    queue.pop_front();
+                }
+
+                func();
+            }
+        }
+    };
+
+    upload_pool& get_upload_pool()
+    {
+        static upload_pool pool;
+
+        return pool;
+    }
+
+    ///the worker may still be writing into the mapped buffer, so this has to wait for it before the buffer can be reused
+    void abandon_upload(std::shared_ptr<texture_upload>& upload)
+    {
+        if(!upload)
+            return;
+
+        upload->wait();
+
+        if(!upload->issued && !upload->buffer.persistent)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload->buffer.pbo);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+
+        release_pixel_buffer(upload->buffer);
+        upload.reset();
+    }
+}
+
+bool texture_format::is_compressed(type t)
+{
+    return t >= BC1;
+}
+
+bool texture_format::is_supported(type t)
+{
+    #ifdef __EMSCRIPTEN__
+    if(!is_compressed(t))
+        return true;
+
+    if(t != BC1 && t != BC3)
+        return false;
+
+    ///webgl extensions have to be enabled before they can be used, and enabling one is also how you find out if it's there
+    static bool has_s3tc = emscripten_webgl_enable_extension(emscripten_webgl_get_current_context(), "WEBGL_compressed_texture_s3tc");
+
+    return has_s3tc;
+    #else
+    switch(t)
+    {
+        case RGBA8:
+        case R8:
+        case RG8:
+            return true;
+        case RGBA16F:
+        case RGBA32F:
+            return GLEW_ARB_texture_float || GLEW_VERSION_3_0;
+        case BC1:
+        case BC3:
+            return GLEW_EXT_texture_compression_s3tc;
+        case BC4:
+        case BC5:
+            return GLEW_ARB_texture_compression_rgtc || GLEW_VERSION_3_0;
+        case BC7:
+            return GLEW_ARB_texture_compression_bptc || GLEW_VERSION_4_2;
+        case ETC2_RGB8:
+        case ETC2_RGBA8:
+            return GLEW_ARB_ES3_compatibility || GLEW_VERSION_4_3;
+    }
+
+    return false;
+    #endif
+}
+
+int texture_format::input_bytes_per_texel(type t)
+{
+    return get_format_info(t, false).input_bytes;
+}
 
 texture::texture()
 {
@@ -11,6 +589,8 @@ texture::texture(texture&& other)
 {
     dim = other.dim;
     handle = other.handle;
+    storage = other.storage;
+    pending = std::move(other.pending);
 
     other.handle = 0;
     other.dim = {0,0};
@@ -23,8 +603,12 @@ texture& texture::operator=(texture&& other)
         glDeleteTextures(1, &handle);
     }
 
+    abandon_upload(pending);
+
     dim = other.dim;
     handle = other.handle;
+    storage = other.storage;
+    pending = std::move(other.pending);
 
     other.handle = 0;
     other.dim = {0,0};
@@ -39,7 +623,10 @@ void texture::load_from_memory(const uint8_t* pixels_rgba, vec2i _dim)
         glDeleteTextures(1, &handle);
     }
 
+    abandon_upload(pending);
+
     dim = _dim;
+    storage = texture_settings();
 
     glGenTextures(1, &handle);
     glBindTexture(GL_TEXTURE_2D, handle);
@@ -54,14 +641,61 @@ void texture::load_from_memory(const uint8_t* pixels_rgba, vec2i _dim)
     glGenerateMipmapEXT(GL_TEXTURE_2D);
 }
 
-void texture::load_from_memory(const texture_settings& settings, const uint8_t* pixels_rgba)
+void texture::load_from_memory(const texture_settings& requested, const uint8_t* pixels_rgba)
 {
+    abandon_upload(pending);
+
+    texture_settings settings = resolve_raw_format(requested);
+
+    format_info info = get_format_info(settings.format, settings.is_srgb);
+
+    if(is_cpu_compressed(settings.format))
+    {
+        ///encoding needs the texels on the cpu, so this can't be fed from a bound unpack buffer
+        assert(pixels_rgba != nullptr);
+
+        int levels = settings.generate_mipmaps ? calculate_mip_levels({settings.width, settings.height}) : 1;
+
+        std::vector<uint8_t> blocks = texture_compression::encode_with_mips(settings.format, pixels_rgba, {settings.width, settings.height}, levels);
+
+        load_compressed_from_memory(settings, blocks.data(), blocks.size(), levels);
+        return;
+    }
+
+    ///with a pixel unpack buffer bound, a null pixel pointer is a valid offset into it
+    GLint unpack_buffer = 0;
+    glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &unpack_buffer);
+
+    bool has_data = pixels_rgba != nullptr || unpack_buffer != 0;
+
+    unpack_alignment_setter align((int64_t)settings.width * info.input_bytes);
+
+    ///same size and format, so the existing storage can be written into rather than reallocated
+    if(handle != 0 && is_same_storage(storage, settings))
+    {
+        storage = settings;
+
+        glBindTexture(GL_TEXTURE_2D, handle);
+        set_filtering(settings);
+
+        if(has_data)
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, dim.x(), dim.y(), info.upload_format, info.upload_type, pixels_rgba);
+
+            if(settings.generate_mipmaps)
+                glGenerateMipmapEXT(GL_TEXTURE_2D);
+        }
+
+        return;
+    }
+
     if(handle != 0)
     {
         glDeleteTextures(1, &handle);
     }
 
     dim = {settings.width, settings.height};
+    storage = settings;
 
     glGenTextures(1, &handle);
     glBindTexture(GL_TEXTURE_2D, handle);
@@ -69,33 +703,375 @@ void texture::load_from_memory(const texture_settings& settings, const uint8_t*
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-    if(settings.shrink_linear)
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    else
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    set_filtering(settings);
+
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 16.f);
+
+    if(GLEW_ARB_texture_storage || GLEW_VERSION_4_2)
+    {
+        int levels = settings.generate_mipmaps ? calculate_mip_levels(dim) : 1;
 
-    if(settings.magnify_linear)
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexStorage2D(GL_TEXTURE_2D, levels, info.internal_format, dim.x(), dim.y());
+
+        if(has_data)
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, dim.x(), dim.y(), info.upload_format, info.upload_type, pixels_rgba);
+    }
     else
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, info.internal_format, dim.x(), dim.y(), 0, info.upload_format, info.upload_type, pixels_rgba);
+    }
+
+    if(settings.generate_mipmaps)
+        glGenerateMipmapEXT(GL_TEXTURE_2D);
+}
+
+void texture::load_compressed_from_memory(const texture_settings& settings, const uint8_t* data, int64_t bytes, int mip_levels)
+{
+    abandon_upload(pending);
+
+    format_info info = get_format_info(settings.format, settings.is_srgb);
+
+    if(!info.compressed)
+        throw std::runtime_error("load_compressed_from_memory needs a block compressed format");
+
+    assert(mip_levels >= 1);
+
+    if(handle != 0)
+    {
+        glDeleteTextures(1, &handle);
+    }
+
+    dim = {settings.width, settings.height};
+    storage = settings;
+
+    glGenTextures(1, &handle);
+    glBindTexture(GL_TEXTURE_2D, handle);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    set_filtering(settings);
 
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 16.f);
 
-    GLint internalformat = 0;
+    ///the chain may be shorter than a full one, so don't let sampling fall off the end of it
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mip_levels - 1);
+
+    bool immutable = GLEW_ARB_texture_storage || GLEW_VERSION_4_2;
 
-    if(settings.is_srgb)
+    if(immutable)
+        glTexStorage2D(GL_TEXTURE_2D, mip_levels, info.internal_format, dim.x(), dim.y());
+
+    int64_t offset = 0;
+
+    for(int level=0; level < mip_levels; level++)
+    {
+        vec2i level_dim = max(dim / (1 << level), (vec2i){1, 1});
+        int64_t level_bytes = texture_compression::get_level_bytes(settings.format, level_dim);
+
+        if(offset + level_bytes > bytes)
+            throw std::runtime_error("Compressed texture data is too small for " + std::to_string(mip_levels) + " levels");
+
+        ///data may be null, with an unpack buffer bound
+        const void* ptr = (const void*)((uintptr_t)data + offset);
+
+        if(immutable)
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, level_dim.x(), level_dim.y(), info.internal_format, level_bytes, ptr);
+        else
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, info.internal_format, level_dim.x(), level_dim.y(), 0, level_bytes, ptr);
+
+        offset += level_bytes;
+    }
+}
+
+void texture::update_region(const uint8_t* pixels_rgba, vec2i pos, vec2i region, bool regenerate_mips)
+{
+    assert(handle != 0);
+    assert(pos.x() >= 0 && pos.y() >= 0);
+    assert(pos.x() + region.x() <= dim.x() && pos.y() + region.y() <= dim.y());
+
+    if(region.x() <= 0 || region.y() <= 0)
+        return;
+
+    format_info info = get_format_info(storage.format, storage.is_srgb);
+
+    glBindTexture(GL_TEXTURE_2D, handle);
+
+    if(info.compressed)
     {
-        internalformat = GL_SRGB8_ALPHA8;
+        if(!texture_compression::can_encode(storage.format))
+            throw std::runtime_error("update_region is not supported for formats which can only be uploaded precompressed");
+
+        ///blocks can only be partially covered at the right and bottom edges of the texture
+        assert((pos.x() % 4) == 0 && (pos.y() % 4) == 0);
+        assert((region.x() % 4) == 0 || pos.x() + region.x() == dim.x());
+        assert((region.y() % 4) == 0 || pos.y() + region.y() == dim.y());
+
+        std::vector<uint8_t> blocks = texture_compression::encode(storage.format, pixels_rgba, region);
+
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, pos.x(), pos.y(), region.x(), region.y(), info.internal_format, blocks.size(), blocks.data());
+        return;
+    }
+
+    unpack_alignment_setter align((int64_t)region.x() * info.input_bytes);
+
+    glTexSubImage2D(GL_TEXTURE_2D, 0, pos.x(), pos.y(), region.x(), region.y(), info.upload_format, info.upload_type, pixels_rgba);
+
+    if(regenerate_mips && storage.generate_mipmaps)
+        regenerate_mip_region(handle, dim, pos, region, storage.is_srgb);
+}
+
+void texture::load_from_memory_async(const texture_settings& settings, std::function<void(uint8_t*)> fill)
+{
+    if(handle != 0)
+    {
+        glDeleteTextures(1, &handle);
+        handle = 0;
+    }
+
+    abandon_upload(pending);
+
+    dim = {settings.width, settings.height};
+
+    size_t bytes = (size_t)settings.width * settings.height * texture_format::input_bytes_per_texel(settings.format);
+
+    #ifdef __EMSCRIPTEN__
+    ///webgl can't map buffers
+    std::vector<uint8_t> pixels;
+    pixels.resize(bytes);
+
+    fill(pixels.data());
+
+    load_from_memory(settings, pixels.data());
+    #else
+    std::shared_ptr<texture_upload> upload = std::make_shared<texture_upload>();
+    upload->settings = settings;
+
+    bool cpu_compressed = is_cpu_compressed(settings.format);
+
+    if(cpu_compressed)
+    {
+        upload->compressed_levels = settings.generate_mipmaps ? calculate_mip_levels(dim) : 1;
+        upload->compressed_bytes = texture_compression::get_chain_bytes(settings.format, dim, upload->compressed_levels);
+
+        upload->buffer = acquire_pixel_buffer(upload->compressed_bytes);
     }
     else
     {
-        internalformat = GL_RGBA32F;
+        upload->buffer = acquire_pixel_buffer(bytes);
     }
 
-    glTexImage2D(GL_TEXTURE_2D, 0, internalformat, dim.x(), dim.y(), 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels_rgba);
+    pending = upload;
 
-    if(settings.generate_mipmaps)
-        glGenerateMipmapEXT(GL_TEXTURE_2D);
+    get_upload_pool().add([upload, bytes, cpu_compressed, fill = std::move(fill)]()
+    {
+        upload_setter sett(upload);
+
+        try
+        {
+            if(!cpu_compressed)
+            {
+                fill(upload->buffer.mapped);
+                return;
+            }
+
+            ///the encoder wants the raw texels, so they can't be decoded straight into the mapped buffer
+            std::vector<uint8_t> pixels;
+            pixels.resize(bytes);
+
+            fill(pixels.data());
+
+            const texture_settings& s = upload->settings;
+
+            std::vector<uint8_t> blocks = texture_compression::encode_with_mips(s.format, pixels.data(), {s.width, s.height}, upload->compressed_levels);
+
+            memcpy(upload->buffer.mapped, blocks.data(), blocks.size());
+        }
+        catch(...)
+        {
+            upload->error = std::current_exception();
+        }
+    });
+    #endif
+}
+
+void texture::load_from_memory_async(const texture_settings& settings, std::vector<uint8_t> pixels_rgba)
+{
+    assert(pixels_rgba.size() >= (size_t)settings.width * settings.height * texture_format::input_bytes_per_texel(settings.format));
+
+    load_from_memory_async(settings, [pixels = std::move(pixels_rgba)](uint8_t* out)
+    {
+        memcpy(out, pixels.data(), (size_t)pixels.size());
+    });
+}
+
+bool texture::is_ready()
+{
+    if(!pending)
+        return handle != 0;
+
+    if(!pending->issued)
+    {
+        if(!pending->try_wait())
+            return false;
+
+        if(pending->error)
+        {
+            std::exception_ptr error = pending->error;
+
+            abandon_upload(pending);
+
+            std::rethrow_exception(error);
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pending->buffer.pbo);
+
+        if(!pending->buffer.persistent)
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        std::shared_ptr<texture_upload> upload = std::move(pending);
+
+        ///with a pixel unpack buffer bound, the pixel pointer is an offset into it
+        if(upload->compressed_levels > 0)
+            load_compressed_from_memory(upload->settings, nullptr, upload->compressed_bytes, upload->compressed_levels);
+        else
+            load_from_memory(upload->settings, nullptr);
+
+        pending = std::move(upload);
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        pending->buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        pending->issued = true;
+
+        glFlush();
+    }
+
+    if(!is_signalled(pending->buffer.fence))
+        return false;
+
+    release_pixel_buffer(pending->buffer);
+    pending.reset();
+
+    return true;
+}
+
+void texture::ensure_ready()
+{
+    if(!pending)
+        return;
+
+    pending->wait();
+
+    is_ready();
+
+    if(!pending)
+        return;
+
+    glClientWaitSync(pending->buffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+
+    is_ready();
+}
+
+struct texture_readback_state
+{
+    vec2i dim;
+    texture_format::type format = texture_format::RGBA8;
+
+    pack_buffer buffer;
+    size_t bytes = 0;
+
+    bool finished = false;
+    std::vector<uint8_t> result;
+
+    void release()
+    {
+        if(buffer.pbo != 0)
+            release_pack_buffer(buffer);
+
+        buffer = pack_buffer();
+    }
+
+    ///copies out of the pack buffer, which is only safe once the fence has signalled
+    void finish()
+    {
+        if(finished)
+            return;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.pbo);
+
+        void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+
+        result.resize(bytes);
+
+        if(mapped != nullptr)
+        {
+            memcpy(result.data(), mapped, bytes);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        release();
+
+        finished = true;
+
+        if(mapped == nullptr)
+            throw std::runtime_error("Could not map pixel buffer for texture readback");
+    }
+
+    ~texture_readback_state()
+    {
+        release();
+    }
+};
+
+bool texture_readback::is_valid()
+{
+    return state != nullptr;
+}
+
+bool texture_readback::is_finished()
+{
+    assert(state);
+
+    if(state->finished)
+        return true;
+
+    if(!is_signalled(state->buffer.fence))
+        return false;
+
+    state->finish();
+
+    return true;
+}
+
+const std::vector<uint8_t>& texture_readback::get()
+{
+    assert(state);
+
+    if(!state->finished)
+    {
+        glClientWaitSync(state->buffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+
+        state->finish();
+    }
+
+    return state->result;
+}
+
+vec2i texture_readback::get_dim()
+{
+    assert(state);
+
+    return state->dim;
+}
+
+texture_format::type texture_readback::get_format()
+{
+    assert(state);
+
+    return state->format;
 }
 
 std::vector<vec4f> texture::read(int mip_level)
@@ -119,6 +1095,92 @@ std::vector<vec4f> texture::read(int mip_level)
     return ret;
 }
 
+texture_readback texture::read_async(texture_format::type format, int mip_level)
+{
+    ///a bad mip level is reported by the overload below
+    vec2i level_dim = max(dim / (1 << std::clamp(mip_level, 0, 30)), (vec2i){1, 1});
+
+    return read_async(format, {0, 0}, level_dim, mip_level);
+}
+
+texture_readback texture::read_async(texture_format::type format, vec2i pos, vec2i region, int mip_level)
+{
+    assert(handle != 0);
+    assert(region.x() > 0 && region.y() > 0);
+
+    if(format != texture_format::RGBA8 && format != texture_format::RGBA32F)
+        throw std::runtime_error("read_async only supports RGBA8 and RGBA32F destinations");
+
+    ///an async upload has to land first, or there's nothing to read
+    ensure_ready();
+
+    if(texture_format::is_compressed(storage.format))
+        throw std::runtime_error("Compressed textures can't be attached for readback");
+
+    int levels = storage.generate_mipmaps ? calculate_mip_levels(dim) : 1;
+
+    if(mip_level < 0 || mip_level >= levels)
+        throw std::runtime_error("read_async mip level " + std::to_string(mip_level) + " is out of range");
+
+    vec2i level_dim = max(dim / (1 << mip_level), (vec2i){1, 1});
+
+    if(pos.x() < 0 || pos.y() < 0 || pos.x() + region.x() > level_dim.x() || pos.y() + region.y() > level_dim.y())
+        throw std::runtime_error("read_async region is outside of mip level " + std::to_string(mip_level));
+
+    std::shared_ptr<texture_readback_state> state = std::make_shared<texture_readback_state>();
+    state->dim = region;
+    state->format = format;
+    state->bytes = (size_t)region.x() * region.y() * (format == texture_format::RGBA8 ? 4 : 16);
+
+    GLenum type = format == texture_format::RGBA8 ? GL_UNSIGNED_BYTE : GL_FLOAT;
+
+    if(readback_fbo == 0)
+        glGenFramebuffers(1, &readback_fbo);
+
+    GLint old_read = 0;
+    GLint old_alignment = 4;
+
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &old_read);
+    glGetIntegerv(GL_PACK_ALIGNMENT, &old_alignment);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, readback_fbo);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, handle, mip_level);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    #ifdef __EMSCRIPTEN__
+    ///webgl can't map buffers, so this is synchronous
+    state->result.resize(state->bytes);
+
+    glReadPixels(pos.x(), pos.y(), region.x(), region.y(), GL_RGBA, type, state->result.data());
+
+    state->finished = true;
+    #else
+    state->buffer = acquire_pack_buffer(state->bytes);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, state->buffer.pbo);
+
+    ///with a pack buffer bound, this is an offset into it and doesn't wait for the gpu
+    glReadPixels(pos.x(), pos.y(), region.x(), region.y(), GL_RGBA, type, nullptr);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    state->buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    glFlush();
+    #endif
+
+    glPixelStorei(GL_PACK_ALIGNMENT, old_alignment);
+
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, old_read);
+
+    texture_readback ret;
+    ret.state = state;
+
+    return ret;
+}
+
 vec2i texture::get_size()
 {
     return dim;
@@ -130,4 +1192,6 @@ texture::~texture()
     {
         glDeleteTextures(1, &handle);
     }
+
+    abandon_upload(pending);
 }
@@ -2,6 +2,39 @@
 #define TEXTURE_HPP_INCLUDED
 
 #include <vec/vec.hpp>
+#include <vector>
+#include <memory>
+#include <functional>
+
+namespace texture_format
+{
+    ///is_srgb picks the srgb variant, where one exists
+    ///float formats take float rgba input, r8/rg8 take 1/2 bytes per texel, everything else takes 8 bit rgba
+    enum type
+    {
+        RGBA8,
+        RGBA16F,
+        RGBA32F,
+        R8,
+        RG8,
+
+        ///block compressed. BC1-5 are encoded on the cpu, with mips built before encoding
+        ///BC7 and ETC2 have no encoder, so they need load_compressed_from_memory. Raw texels given for them are stored as RGBA8
+        BC1,
+        BC3,
+        BC4,
+        BC5,
+        BC7,
+        ETC2_RGB8,
+        ETC2_RGBA8,
+    };
+
+    bool is_compressed(type t);
+    bool is_supported(type t);
+
+    ///size of one texel of the input pixel data
+    int input_bytes_per_texel(type t);
+}
 
 struct texture_settings
 {
@@ -9,11 +42,32 @@ struct texture_settings
     int height = 0;
     bool is_srgb = true;
     bool generate_mipmaps = true;
+    texture_format::type format = texture_format::RGBA8;
 
     bool magnify_linear = true;
     bool shrink_linear = true;
 };
 
+struct texture_upload;
+struct texture_readback_state;
+
+///the result of texture::read_async. Gl thread only
+struct texture_readback
+{
+    std::shared_ptr<texture_readback_state> state;
+
+    bool is_valid();
+
+    ///non blocking
+    bool is_finished();
+
+    ///blocks if the readback hasn't finished yet. Tightly packed rows, bottom row first, in the format that was requested
+    const std::vector<uint8_t>& get();
+
+    vec2i get_dim();
+    texture_format::type get_format();
+};
+
 struct texture
 {
     unsigned int handle = 0;
@@ -28,14 +82,43 @@ struct texture
     [[deprecated]]
     void load_from_memory(const uint8_t* pixels_rgba, vec2i dim);
 
+    ///reuses the existing storage if the size and format are unchanged
     void load_from_memory(const texture_settings& settings, const uint8_t* pixels_rgba);
 
+    ///data holds mip_levels tightly packed levels of blocks in settings.format, largest first
+    void load_compressed_from_memory(const texture_settings& settings, const uint8_t* data, int64_t bytes, int mip_levels = 1);
+
+    ///writes a sub rectangle in place. If the texture has mipmaps, only the mip texels that depend on the region are rebuilt
+    ///compressed textures need the region to be block aligned, and their mips are not rebuilt
+    void update_region(const uint8_t* pixels_rgba, vec2i pos, vec2i region, bool regenerate_mips = true);
+
+    ///fill is called on a worker thread, and must write width * height * input_bytes_per_texel bytes into the pointer it's given
+    ///the pointer is a mapped pixel buffer, so decoding straight into it avoids an extra copy
+    ///handle stays 0 until the upload has been issued, check is_ready before using the texture
+    ///fills share a few worker threads. If fill throws, the exception is rethrown from is_ready or ensure_ready
+    void load_from_memory_async(const texture_settings& settings, std::function<void(uint8_t*)> fill);
+    void load_from_memory_async(const texture_settings& settings, std::vector<uint8_t> pixels_rgba);
+
+    ///gl thread only, these drive a pending async upload forwards
+    bool is_ready();
+    void ensure_ready();
+
+    ///stalls until the gpu has caught up, prefer read_async
     std::vector<vec4f> read(int mip_level = 0);
 
+    ///queues a copy into a pixel pack buffer behind a fence, and returns immediately
+    ///format must be RGBA8 or RGBA32F, and compressed textures can't be read back this way
+    texture_readback read_async(texture_format::type format = texture_format::RGBA8, int mip_level = 0);
+    texture_readback read_async(texture_format::type format, vec2i pos, vec2i region, int mip_level = 0);
+
     vec2i get_size();
     ~texture();
 
     vec2i dim;
+
+private:
+    texture_settings storage;
+    std::shared_ptr<texture_upload> pending;
 };
 
 #endif // TEXTURE_HPP_INCLUDED
@@ -0,0 +1,226 @@
+#include "texture_atlas.hpp"
+#include "texture.hpp"
+#include <stdexcept>
+#include <optional>
+#include <assert.h>
+#include <algorithm>
+
+struct texture_atlas::page
+{
+    texture tex;
+    vec2i dim;
+
+    atlas_packer packer;
+
+    ///padded rects
+    std::vector<atlas_rect> entries;
+    std::vector<bool> alive;
+    std::vector<int> free_ids;
+    int live_count = 0;
+
+    bool oversized = false;
+};
+
+vec2f atlas_region::to_page_uv(vec2f uv) const
+{
+    return uv_min + (uv_max - uv_min) * uv;
+}
+
+texture_atlas::texture_atlas(vec2i _page_dim, int _padding, bool _is_srgb) : page_dim(_page_dim), padding(_padding), is_srgb(_is_srgb)
+{
+    assert(padding >= 0);
+}
+
+texture_atlas::~texture_atlas() = default;
+
+int texture_atlas::make_page(vec2i dim)
+{
+    std::unique_ptr<page> p = std::make_unique<page>();
+
+    p->dim = dim;
+    p->packer.reset(dim);
+
+    texture_settings sett;
+    sett.width = dim.x();
+    sett.height = dim.y();
+    sett.is_srgb = is_srgb;
+    sett.generate_mipmaps = true;
+
+    ///entries get edge padding, but the mip chain can still pull in texels from unused space, so make it defined
+    std::vector<uint8_t> zero;
+    zero.resize((size_t)dim.x() * dim.y() * 4);
+
+    p->tex.load_from_memory(sett, zero.data());
+
+    ///reuse the slot of a released page, so that the indices of live pages don't move
+    for(int i=0; i < (int)pages.size(); i++)
+    {
+        if(pages[i] == nullptr)
+        {
+            pages[i] = std::move(p);
+            return i;
+        }
+    }
+
+    pages.push_back(std::move(p));
+
+    return (int)pages.size() - 1;
+}
+
+atlas_handle texture_atlas::insert(const uint8_t* pixels_rgba, vec2i dim)
+{
+    assert(dim.x() > 0 && dim.y() > 0);
+
+    vec2i padded_dim = dim + (vec2i){padding * 2, padding * 2};
+
+    page* found = nullptr;
+    std::optional<vec2i> found_pos;
+    int found_idx = -1;
+
+    for(int i=0; i < (int)pages.size(); i++)
+    {
+        ///left for the image it was made for, so that it can be released along with it
+        if(pages[i] == nullptr || pages[i]->oversized)
+            continue;
+
+        std::optional<vec2i> pos = pages[i]->packer.find(padded_dim);
+
+        if(pos.has_value())
+        {
+            found = pages[i].get();
+            found_pos = pos;
+            found_idx = i;
+            break;
+        }
+    }
+
+    if(found == nullptr)
+    {
+        ///oversized images get a page to themselves
+        vec2i next_dim = max(page_dim, padded_dim);
+
+        found_idx = make_page(next_dim);
+        found = pages[found_idx].get();
+        found->oversized = next_dim.x() > page_dim.x() || next_dim.y() > page_dim.y();
+        found_pos = found->packer.find(padded_dim);
+
+        assert(found_pos.has_value());
+    }
+
+    atlas_rect used = {found_pos.value(), padded_dim};
+
+    found->packer.place(used);
+
+    int id = -1;
+
+    if(found->free_ids.size() > 0)
+    {
+        id = found->free_ids.back();
+        found->free_ids.pop_back();
+
+        found->entries[id] = used;
+        found->alive[id] = true;
+    }
+    else
+    {
+        id = (int)found->entries.size();
+
+        found->entries.push_back(used);
+        found->alive.push_back(true);
+    }
+
+    found->live_count++;
+
+    ///replicate the edges of the image out into the padding
+    std::vector<uint8_t> padded;
+    padded.resize((size_t)padded_dim.x() * padded_dim.y() * 4);
+
+    for(int y=0; y < padded_dim.y(); y++)
+    {
+        int sy = std::clamp(y - padding, 0, dim.y() - 1);
+
+        for(int x=0; x < padded_dim.x(); x++)
+        {
+            int sx = std::clamp(x - padding, 0, dim.x() - 1);
+
+            for(int c=0; c < 4; c++)
+            {
+                padded[((size_t)y * padded_dim.x() + x) * 4 + c] = pixels_rgba[((size_t)sy * dim.x() + sx) * 4 + c];
+            }
+        }
+    }
+
+    found->tex.update_region(padded.data(), used.pos, used.dim);
+
+    return {found_idx, id};
+}
+
+void texture_atlas::remove(atlas_handle handle)
+{
+    if(!handle.is_valid() || handle.page >= (int)pages.size() || pages[handle.page] == nullptr)
+        return;
+
+    page& p = *pages[handle.page];
+
+    if(handle.id >= (int)p.entries.size() || !p.alive[handle.id])
+        return;
+
+    p.alive[handle.id] = false;
+    p.free_ids.push_back(handle.id);
+    p.live_count--;
+
+    if(p.live_count == 0)
+    {
+        ///an oversized page only ever holds the one image it was made for
+        if(p.oversized)
+        {
+            pages[handle.page].reset();
+            return;
+        }
+
+        p.packer.reset(p.dim);
+        return;
+    }
+
+    p.packer.release(p.entries[handle.id]);
+}
+
+atlas_region texture_atlas::get(atlas_handle handle)
+{
+    if(!handle.is_valid() || handle.page >= (int)pages.size() || pages[handle.page] == nullptr)
+        throw std::runtime_error("Bad atlas handle");
+
+    page& p = *pages[handle.page];
+
+    if(handle.id >= (int)p.entries.size() || !p.alive[handle.id])
+        throw std::runtime_error("Atlas handle refers to an evicted entry");
+
+    atlas_rect padded = p.entries[handle.id];
+
+    atlas_region ret;
+    ret.tex = &p.tex;
+    ret.pos = padded.pos + (vec2i){padding, padding};
+    ret.dim = padded.dim - (vec2i){padding * 2, padding * 2};
+
+    vec2f fdim = {(float)p.dim.x(), (float)p.dim.y()};
+
+    ret.uv_min = (vec2f){(float)ret.pos.x(), (float)ret.pos.y()} / fdim;
+    ret.uv_max = (vec2f){(float)(ret.pos.x() + ret.dim.x()), (float)(ret.pos.y() + ret.dim.y())} / fdim;
+
+    return ret;
+}
+
+int texture_atlas::get_page_count()
+{
+    return pages.size();
+}
+
+texture* texture_atlas::get_page(int idx)
+{
+    assert(idx >= 0 && idx < (int)pages.size());
+
+    if(pages[idx] == nullptr)
+        return nullptr;
+
+    return &pages[idx]->tex;
+}
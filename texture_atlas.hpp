@@ -0,0 +1,69 @@
+#ifndef TEXTURE_ATLAS_HPP_INCLUDED
+#define TEXTURE_ATLAS_HPP_INCLUDED
+
+#include <vec/vec.hpp>
+#include "atlas_packer.hpp"
+#include <vector>
+#include <memory>
+#include <stdint.h>
+
+struct texture;
+
+struct atlas_handle
+{
+    int page = -1;
+    int id = -1;
+
+    bool is_valid() const {return page >= 0 && id >= 0;}
+};
+
+struct atlas_region
+{
+    texture* tex = nullptr;
+
+    ///in texels, excluding padding
+    vec2i pos;
+    vec2i dim;
+
+    vec2f uv_min;
+    vec2f uv_max;
+
+    ///maps a normalised uv within the sub image to a uv within the atlas page
+    vec2f to_page_uv(vec2f uv) const;
+};
+
+///packs many small rgba images into shared texture pages, using maxrects with best short side fit
+///every entry is surrounded by padding texels which replicate its edges, so that bilinear filtering doesn't bleed
+struct texture_atlas
+{
+    texture_atlas(vec2i page_dim = {2048, 2048}, int padding = 1, bool is_srgb = true);
+    ~texture_atlas();
+
+    texture_atlas(const texture_atlas&) = delete;
+    texture_atlas& operator=(const texture_atlas&) = delete;
+
+    ///uploads immediately, and only regenerates the mips that overlap the inserted area
+    atlas_handle insert(const uint8_t* pixels_rgba, vec2i dim);
+    void remove(atlas_handle handle);
+
+    atlas_region get(atlas_handle handle);
+
+    ///oversized images get a page to themselves, which is released once they're removed
+    int get_page_count();
+    ///nullptr for a released page
+    texture* get_page(int idx);
+
+private:
+    struct page;
+
+    vec2i page_dim;
+    int padding = 1;
+    bool is_srgb = true;
+
+    std::vector<std::unique_ptr<page>> pages;
+
+    ///returns the page's index
+    int make_page(vec2i dim);
+};
+
+#endif // TEXTURE_ATLAS_HPP_INCLUDED
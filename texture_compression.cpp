@@ -0,0 +1,377 @@
+#include "texture_compression.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string.h>
+#include <assert.h>
+
+namespace
+{
+    ///clamps at the image edge, so partial blocks repeat their last row/column
+    void fetch_block(const uint8_t* pixels_rgba, vec2i dim, int bx, int by, uint8_t out[16][4])
+    {
+        for(int y=0; y < 4; y++)
+        {
+            int sy = std::min(by * 4 + y, dim.y() - 1);
+
+            for(int x=0; x < 4; x++)
+            {
+                int sx = std::min(bx * 4 + x, dim.x() - 1);
+
+                memcpy(out[y * 4 + x], &pixels_rgba[((size_t)sy * dim.x() + sx) * 4], 4);
+            }
+        }
+    }
+
+    uint16_t to_565(const int col[3])
+    {
+        return (uint16_t)(((col[0] >> 3) << 11) | ((col[1] >> 2) << 5) | (col[2] >> 3));
+    }
+
+    void from_565(uint16_t in, int out[3])
+    {
+        int r = (in >> 11) & 31;
+        int g = (in >> 5) & 63;
+        int b = in & 31;
+
+        out[0] = (r << 3) | (r >> 2);
+        out[1] = (g << 2) | (g >> 4);
+        out[2] = (b << 3) | (b >> 2);
+    }
+
+    void write_u16(uint8_t* out, uint16_t val)
+    {
+        out[0] = val & 0xFF;
+        out[1] = (val >> 8) & 0xFF;
+    }
+
+    int colour_distance(const int c1[3], const uint8_t c2[4])
+    {
+        int dr = c1[0] - c2[0];
+        int dg = c1[1] - c2[1];
+        int db = c1[2] - c2[2];
+
+        return dr * dr + dg * dg + db * db;
+    }
+
+    ///8 bytes. With allow_alpha, texels with alpha < 128 use the punchthrough mode
+    void encode_bc1_block(const uint8_t block[16][4], bool allow_alpha, uint8_t* out)
+    {
+        int lo[3] = {255, 255, 255};
+        int hi[3] = {0, 0, 0};
+
+        bool any_transparent = false;
+        bool any_opaque = false;
+
+        for(int i=0; i < 16; i++)
+        {
+            if(allow_alpha && block[i][3] < 128)
+            {
+                any_transparent = true;
+                continue;
+            }
+
+            any_opaque = true;
+
+            for(int c=0; c < 3; c++)
+            {
+                lo[c] = std::min(lo[c], (int)block[i][c]);
+                hi[c] = std::max(hi[c], (int)block[i][c]);
+            }
+        }
+
+        if(!any_opaque)
+        {
+            ///c0 <= c1 and every index 3 is fully transparent
+            write_u16(out, 0);
+            write_u16(out + 2, 0);
+            memset(out + 4, 0xFF, 4);
+            return;
+        }
+
+        ///inset the bounding box slightly, the extremes are rarely the best endpoints
+        for(int c=0; c < 3; c++)
+        {
+            int inset = (hi[c] - lo[c]) / 16;
+
+            lo[c] = std::min(lo[c] + inset, 255);
+            hi[c] = std::max(hi[c] - inset, 0);
+        }
+
+        uint16_t c0 = to_565(hi);
+        uint16_t c1 = to_565(lo);
+
+        ///c0 > c1 selects the 4 colour mode, c0 <= c1 selects 3 colours + transparent
+        if(any_transparent ? c0 > c1 : c0 < c1)
+            std::swap(c0, c1);
+
+        int palette[4][3] = {};
+
+        from_565(c0, palette[0]);
+        from_565(c1, palette[1]);
+
+        int palette_size = 0;
+
+        if(c0 > c1)
+        {
+            for(int c=0; c < 3; c++)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            palette_size = 4;
+        }
+        else
+        {
+            for(int c=0; c < 3; c++)
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            }
+
+            palette_size = 3;
+        }
+
+        uint32_t indices = 0;
+
+        for(int i=0; i < 16; i++)
+        {
+            uint32_t best = 0;
+
+            if(allow_alpha && block[i][3] < 128)
+            {
+                best = 3;
+            }
+            else
+            {
+                int best_dist = colour_distance(palette[0], block[i]);
+
+                for(int p=1; p < palette_size; p++)
+                {
+                    int dist = colour_distance(palette[p], block[i]);
+
+                    if(dist < best_dist)
+                    {
+                        best_dist = dist;
+                        best = p;
+                    }
+                }
+            }
+
+            indices |= best << (i * 2);
+        }
+
+        write_u16(out, c0);
+        write_u16(out + 2, c1);
+
+        for(int i=0; i < 4; i++)
+        {
+            out[4 + i] = (indices >> (i * 8)) & 0xFF;
+        }
+    }
+
+    ///8 bytes, encodes one channel of the block
+    void encode_bc4_block(const uint8_t block[16][4], int channel, uint8_t* out)
+    {
+        int lo = 255;
+        int hi = 0;
+
+        for(int i=0; i < 16; i++)
+        {
+            lo = std::min(lo, (int)block[i][channel]);
+            hi = std::max(hi, (int)block[i][channel]);
+        }
+
+        out[0] = hi;
+        out[1] = lo;
+
+        uint64_t indices = 0;
+
+        if(hi != lo)
+        {
+            ///a0 > a1 selects the 8 value mode
+            int palette[8] = {};
+            palette[0] = hi;
+            palette[1] = lo;
+
+            for(int i=2; i < 8; i++)
+            {
+                palette[i] = ((8 - i) * hi + (i - 1) * lo) / 7;
+            }
+
+            for(int i=0; i < 16; i++)
+            {
+                int val = block[i][channel];
+
+                uint64_t best = 0;
+                int best_dist = abs(palette[0] - val);
+
+                for(int p=1; p < 8; p++)
+                {
+                    int dist = abs(palette[p] - val);
+
+                    if(dist < best_dist)
+                    {
+                        best_dist = dist;
+                        best = p;
+                    }
+                }
+
+                indices |= best << (i * 3);
+            }
+        }
+
+        for(int i=0; i < 6; i++)
+        {
+            out[2 + i] = (indices >> (i * 8)) & 0xFF;
+        }
+    }
+
+    std::vector<uint8_t> downsample(const uint8_t* pixels_rgba, vec2i dim, vec2i next_dim)
+    {
+        std::vector<uint8_t> ret;
+        ret.resize((size_t)next_dim.x() * next_dim.y() * 4);
+
+        for(int y=0; y < next_dim.y(); y++)
+        {
+            int y0 = std::min(y * 2, dim.y() - 1);
+            int y1 = std::min(y * 2 + 1, dim.y() - 1);
+
+            for(int x=0; x < next_dim.x(); x++)
+            {
+                int x0 = std::min(x * 2, dim.x() - 1);
+                int x1 = std::min(x * 2 + 1, dim.x() - 1);
+
+                for(int c=0; c < 4; c++)
+                {
+                    int sum = pixels_rgba[((size_t)y0 * dim.x() + x0) * 4 + c] +
+                              pixels_rgba[((size_t)y0 * dim.x() + x1) * 4 + c] +
+                              pixels_rgba[((size_t)y1 * dim.x() + x0) * 4 + c] +
+                              pixels_rgba[((size_t)y1 * dim.x() + x1) * 4 + c];
+
+                    ret[((size_t)y * next_dim.x() + x) * 4 + c] = (sum + 2) / 4;
+                }
+            }
+        }
+
+        return ret;
+    }
+
+    vec2i get_level_dim(vec2i dim, int level)
+    {
+        return {std::max(dim.x() >> level, 1), std::max(dim.y() >> level, 1)};
+    }
+}
+
+bool texture_compression::can_encode(texture_format::type fmt)
+{
+    return fmt == texture_format::BC1 || fmt == texture_format::BC3 || fmt == texture_format::BC4 || fmt == texture_format::BC5;
+}
+
+int texture_compression::get_block_bytes(texture_format::type fmt)
+{
+    switch(fmt)
+    {
+        case texture_format::BC1:
+        case texture_format::BC4:
+        case texture_format::ETC2_RGB8:
+            return 8;
+        case texture_format::BC3:
+        case texture_format::BC5:
+        case texture_format::BC7:
+        case texture_format::ETC2_RGBA8:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+int64_t texture_compression::get_level_bytes(texture_format::type fmt, vec2i dim)
+{
+    int64_t blocks_x = (dim.x() + 3) / 4;
+    int64_t blocks_y = (dim.y() + 3) / 4;
+
+    return blocks_x * blocks_y * get_block_bytes(fmt);
+}
+
+int64_t texture_compression::get_chain_bytes(texture_format::type fmt, vec2i dim, int mip_levels)
+{
+    int64_t ret = 0;
+
+    for(int i=0; i < mip_levels; i++)
+    {
+        ret += get_level_bytes(fmt, get_level_dim(dim, i));
+    }
+
+    return ret;
+}
+
+std::vector<uint8_t> texture_compression::encode(texture_format::type fmt, const uint8_t* pixels_rgba, vec2i dim)
+{
+    if(!can_encode(fmt))
+        throw std::runtime_error("No cpu encoder for texture format " + std::to_string((int)fmt));
+
+    int blocks_x = (dim.x() + 3) / 4;
+    int blocks_y = (dim.y() + 3) / 4;
+    int block_bytes = get_block_bytes(fmt);
+
+    std::vector<uint8_t> ret;
+    ret.resize((size_t)blocks_x * blocks_y * block_bytes);
+
+    uint8_t block[16][4] = {};
+
+    for(int by=0; by < blocks_y; by++)
+    {
+        for(int bx=0; bx < blocks_x; bx++)
+        {
+            fetch_block(pixels_rgba, dim, bx, by, block);
+
+            uint8_t* out = &ret[((size_t)by * blocks_x + bx) * block_bytes];
+
+            if(fmt == texture_format::BC1)
+            {
+                encode_bc1_block(block, true, out);
+            }
+            else if(fmt == texture_format::BC3)
+            {
+                encode_bc4_block(block, 3, out);
+                encode_bc1_block(block, false, out + 8);
+            }
+            else if(fmt == texture_format::BC4)
+            {
+                encode_bc4_block(block, 0, out);
+            }
+            else if(fmt == texture_format::BC5)
+            {
+                encode_bc4_block(block, 0, out);
+                encode_bc4_block(block, 1, out + 8);
+            }
+        }
+    }
+
+    return ret;
+}
+
+std::vector<uint8_t> texture_compression::encode_with_mips(texture_format::type fmt, const uint8_t* pixels_rgba, vec2i dim, int mip_levels)
+{
+    assert(mip_levels >= 1);
+
+    std::vector<uint8_t> ret = encode(fmt, pixels_rgba, dim);
+
+    std::vector<uint8_t> current;
+
+    for(int level=1; level < mip_levels; level++)
+    {
+        vec2i prev_dim = get_level_dim(dim, level - 1);
+        vec2i next_dim = get_level_dim(dim, level);
+
+        const uint8_t* prev = level == 1 ? pixels_rgba : current.data();
+
+        current = downsample(prev, prev_dim, next_dim);
+
+        std::vector<uint8_t> blocks = encode(fmt, current.data(), next_dim);
+
+        ret.insert(ret.end(), blocks.begin(), blocks.end());
+    }
+
+    return ret;
+}
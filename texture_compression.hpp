@@ -0,0 +1,23 @@
+#ifndef TEXTURE_COMPRESSION_HPP_INCLUDED
+#define TEXTURE_COMPRESSION_HPP_INCLUDED
+
+#include "texture.hpp"
+#include <vector>
+#include <stdint.h>
+
+///cpu side block compression. Quality is bounding box fit, which is fine for ui and sprite art
+namespace texture_compression
+{
+    bool can_encode(texture_format::type fmt);
+    int get_block_bytes(texture_format::type fmt);
+    int64_t get_level_bytes(texture_format::type fmt, vec2i dim);
+
+    ///takes 8 bit rgba, and returns blocks in row order
+    std::vector<uint8_t> encode(texture_format::type fmt, const uint8_t* pixels_rgba, vec2i dim);
+
+    ///encodes mip_levels levels, box filtering between each, tightly packed largest first
+    std::vector<uint8_t> encode_with_mips(texture_format::type fmt, const uint8_t* pixels_rgba, vec2i dim, int mip_levels);
+    int64_t get_chain_bytes(texture_format::type fmt, vec2i dim, int mip_levels);
+}
+
+#endif // TEXTURE_COMPRESSION_HPP_INCLUDED